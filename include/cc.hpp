@@ -36,5 +36,24 @@
 #include "ccData.hpp"
 #include "ccGeometry.hpp"
 #include "ccConstants.hpp"
+#include "ccSummary.hpp"
+#include "ccCache.hpp"
+#include "ccSnapshot.hpp"
+#include "ccNfp.hpp"
+#include "ccNest.hpp"
+#include "ccPack.hpp"
+#include "ccLattice.hpp"
+#include "ccCommonLine.hpp"
+#include "ccPath.hpp"
+#include "ccMotion.hpp"
+#include "ccOffset.hpp"
+#include "ccTopology.hpp"
+#include "ccWeld.hpp"
+#include "ccSimplify.hpp"
+#include "ccBiarc.hpp"
+#include "ccKernel.hpp"
+#include "ccShape.hpp"
+#include "ccSmall.hpp"
+#include "ccService.hpp"
 
 #endif /* end of include guard: CC_HEADER_INCLUDED */
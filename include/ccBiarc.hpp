@@ -0,0 +1,283 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccBiarc.hpp
+/// \brief Fitting runs of short segments with pairs of tangent arcs
+
+#ifndef CC_BIARC_HEADER_INCLUDED
+#define CC_BIARC_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2
+#include "ccMacros.hpp"     //< PI
+#include "ccOffset.hpp"     //< Piece
+
+namespace cc{
+
+  /// \brief Biarc approximation of polylines
+  ///
+  /// A biarc joins two points with given tangents by two arcs meeting
+  /// tangentially (the equal distance construction).  A run of points is
+  /// covered greedily: from each start, the farthest end whose biarc (or
+  /// straight chord) passes within tolerance of every segment between is
+  /// found by doubling then bisecting, so a run of n points costs O(n log n).
+  /// Each segment's distance from the pieces is bounded in closed form (see
+  /// Deviation), and as the chain runs from one end of the pieces to the
+  /// other, crossing every normal of theirs, the pieces are as near the chain:
+  /// the fit is within tolerance both ways.  Tangents are central differences inside the
+  /// run, and at its ends the chord turned by half the next turn (exact for
+  /// points on a circle).  Vertices turning by more than `corner` radians
+  /// split runs, so real corners are kept.
+  struct Biarc{
+
+    /// Arc (or line, if straight) leaving p along unit tangent t and ending at x
+    static Piece Toward( const Vec2& p, const Vec2& t, const Vec2& x );
+
+    /// The two pieces of a biarc from p0 (tangent t0) to p1 (tangent t1)
+    /// \returns false if no biarc of arcs under half a turn exists
+    static bool Fit( const Vec2& p0, const Vec2& t0, const Vec2& p1, const Vec2& t1, Piece& a, Piece& b );
+
+    /// Distance from a point to a piece
+    static double Distance( const Piece& p, const Vec2& x );
+
+    /// Greatest distance of the points of segment u v from a line or an arc
+    /// of at most half a turn, bounded from above
+    static double Deviation( const Piece& p, const Vec2& u, const Vec2& v );
+
+    /// Greatest distance of the points of segment u v from the nearest of
+    /// pieces, bounded from above
+    static double Deviation( const std::vector<Piece>& pieces, const Vec2& u, const Vec2& v );
+
+    /// Pieces covering a chain of points within tolerance (closed if the
+    /// last point joins the first).  `start` holds, for each piece, the index
+    /// of the chain point it starts at, or -1 if it starts at a new joint
+    static std::vector<Piece> Polyline( const std::vector<Vec2>& points, bool closed, double tolerance,
+                                        std::vector<int>& start, double corner = PI / 6 );
+  };
+
+    //--------------------------------------------------------------------------
+    inline Piece Biarc::Toward( const Vec2& p, const Vec2& t, const Vec2& x ){
+      Piece q;
+      q.a = p; q.b = x;
+      Vec2 d = x - p;
+      Vec2 n = { -t.y, t.x };
+      double h = Vec2::Dot( n, d ), l2 = Vec2::Dot( d, d );
+      // nearly straight: a line is within a hair of the arc
+      if (fabs(h) * 1e6 < sqrt(l2)) return q;
+      double r = l2 / (2 * h);
+      q.center = p + Vec2{ n.x * r, n.y * r };
+      double s = Offset::Angle( p - q.center, x - q.center );
+      if (r > 0 && s < 0) s += 2*PI;
+      if (r < 0 && s > 0) s -= 2*PI;
+      q.sweep = s;
+      if (fabs(s) < 1e-6) q.sweep = 0;
+      return q;
+    }
+
+    //--------------------------------------------------------------------------
+    inline bool Biarc::Fit( const Vec2& p0, const Vec2& t0, const Vec2& p1, const Vec2& t1, Piece& a, Piece& b ){
+      Vec2 v = p1 - p0;
+      Vec2 t = t0 + t1;
+      double vt = Vec2::Dot( v, t ), vv = Vec2::Dot( v, v );
+      double k = 2 * (1 - Vec2::Dot( t0, t1 ));
+      double d;
+      if (k < 1e-12){
+        if (Vec2::Dot( v, t0 ) <= 0) return false;
+        d = vv / (4 * Vec2::Dot( v, t0 ));
+      } else {
+        d = ( -vt + sqrt( vt*vt + k*vv ) ) / k;
+      }
+      if (!(d > 0)) return false;
+      Vec2 q0 = p0 + Vec2{ t0.x * d, t0.y * d };
+      Vec2 q1 = p1 - Vec2{ t1.x * d, t1.y * d };
+      Vec2 m = { (q0.x + q1.x) / 2, (q0.y + q1.y) / 2 };
+      a = Toward( p0, t0, m );
+      b = Toward( p1, Vec2{ -t1.x, -t1.y }, m ).reversed();
+      return fabs(a.sweep) <= PI && fabs(b.sweep) <= PI;
+    }
+
+    //--------------------------------------------------------------------------
+    inline double Biarc::Distance( const Piece& p, const Vec2& x ){
+      if (!p.arc()){
+        Vec2 d = p.b - p.a;
+        double l2 = Vec2::Dot( d, d );
+        double s = l2 > 0 ? std::max( 0.0, std::min( 1.0, Vec2::Dot( x - p.a, d ) / l2 ) ) : 0;
+        return (x - (p.a + Vec2{ d.x * s, d.y * s })).norm();
+      }
+      // within the arc's angular span, distance to the circle; else to the nearer end
+      double s = Offset::Angle( p.a - p.center, x - p.center );
+      if (p.sweep > 0 && s < 0) s += 2*PI;
+      if (p.sweep < 0 && s > 0) s -= 2*PI;
+      if (fabs(s) <= fabs(p.sweep)) return fabs( (x - p.center).norm() - p.radius() );
+      return std::min( (x - p.a).norm(), (x - p.b).norm() );
+    }
+
+    //--------------------------------------------------------------------------
+    /// Deviation implementation:
+    /// distance to a line segment is convex along u v, so greatest at an end.
+    /// An arc of at most half a turn is nearest along its circle inside its
+    /// wedge (convex, so met by u v in one interval), where distance from the
+    /// center is convex too, greatest at an end and least at the foot of the
+    /// center; outside the wedge it is nearest at one of its ends
+    inline double Biarc::Deviation( const Piece& p, const Vec2& u, const Vec2& v ){
+      if (!p.arc()) return std::max( Distance( p, u ), Distance( p, v ) );
+      Vec2 a = p.a - p.center, b = p.b - p.center, du = u - p.center, dv = v - p.center;
+      if (p.sweep < 0) std::swap( a, b );
+      auto at = [&]( double t ){ return u + Vec2{ (v.x - u.x) * t, (v.y - u.y) * t }; };
+
+      ///1. Interval [t0, t1] of u v in the wedge, counterclockwise from a to b
+      double t0 = 0, t1 = 1;
+      auto clip = [&]( double f0, double f1 ){
+        if (f0 < 0 && f1 < 0) { t0 = 1; t1 = 0; }
+        else if (f0 < 0) t0 = std::max( t0, f0 / (f0 - f1) );
+        else if (f1 < 0) t1 = std::min( t1, f0 / (f0 - f1) );
+      };
+      clip( Vec2::Cross( a, du ), Vec2::Cross( a, dv ) );
+      clip( Vec2::Cross( du, b ), Vec2::Cross( dv, b ) );
+
+      ///2. Along the circle inside, to the nearer end of the arc outside
+      auto outside = [&]( double s0, double s1 ){
+        Vec2 x0 = at(s0), x1 = at(s1);
+        return std::min( std::max( (x0 - p.a).norm(), (x1 - p.a).norm() ),
+                         std::max( (x0 - p.b).norm(), (x1 - p.b).norm() ) );
+      };
+      if (t0 > t1) return outside( 0, 1 );
+      Piece inside;
+      inside.a = at(t0); inside.b = at(t1);
+      double r = p.radius();
+      double far = std::max( (inside.a - p.center).norm(), (inside.b - p.center).norm() );
+      double worst = std::max( far - r, r - Distance( inside, p.center ) );
+      if (t0 > 0) worst = std::max( worst, outside( 0, t0 ) );
+      if (t1 < 1) worst = std::max( worst, outside( t1, 1 ) );
+      return worst;
+    }
+
+    //--------------------------------------------------------------------------
+    /// Deviation from several pieces:
+    /// u v is cut where it crosses the sides of any arc's wedge, so each part
+    /// lies wholly inside or outside every wedge, and each part is bounded by
+    /// the piece it is nearest
+    inline double Biarc::Deviation( const std::vector<Piece>& pieces, const Vec2& u, const Vec2& v ){
+      std::vector<double> cuts = { 0, 1 };
+      for (auto& p : pieces){
+        if (!p.arc()) continue;
+        for (const Vec2& e : { p.a, p.b }){
+          double f0 = Vec2::Cross( e - p.center, u - p.center ), f1 = Vec2::Cross( e - p.center, v - p.center );
+          if ((f0 < 0) != (f1 < 0)) cuts.push_back( f0 / (f0 - f1) );
+        }
+      }
+      std::sort( cuts.begin(), cuts.end() );
+      double worst = 0;
+      for (size_t k=0; k+1<cuts.size(); ++k){
+        Vec2 x0 = u + Vec2{ (v.x - u.x) * cuts[k], (v.y - u.y) * cuts[k] };
+        Vec2 x1 = u + Vec2{ (v.x - u.x) * cuts[k+1], (v.y - u.y) * cuts[k+1] };
+        double best = 1e300;
+        for (auto& p : pieces) best = std::min( best, Deviation( p, x0, x1 ) );
+        worst = std::max( worst, best );
+      }
+      return worst;
+    }
+
+    //--------------------------------------------------------------------------
+    inline std::vector<Piece> Biarc::Polyline( const std::vector<Vec2>& points, bool closed, double tolerance,
+                                               std::vector<int>& start, double corner ){
+
+      std::vector<Piece> result;
+      start.clear();
+      int n = points.size();
+      int m = closed ? n : n - 1;   // segments
+      if (m < 1) return result;
+      auto P = [&]( int i ) -> const Vec2& { return points[ ((i % n) + n) % n ]; };
+      auto turn = [&]( int i ){ return Offset::Angle( P(i) - P(i-1), P(i+1) - P(i) ); };
+
+      ///1. Vertices where runs break: chain ends and corners
+      std::vector<int> breaks;
+      for (int i = closed ? 0 : 1; i < m; ++i) if (fabs( turn(i) ) > corner) breaks.push_back(i);
+      if (!closed) { breaks.insert( breaks.begin(), 0 ); breaks.push_back(m); }
+      else if (breaks.empty()) breaks.push_back(0);
+      else breaks.push_back( breaks.front() + m );
+      bool smooth = closed && breaks.size() == 1;
+      if (smooth) breaks.push_back(m);
+
+      auto rotate = []( const Vec2& u, double a ){
+        return Vec2{ u.x * cos(a) - u.y * sin(a), u.x * sin(a) + u.y * cos(a) };
+      };
+
+      ///2. Cover each run [r0, r1] greedily
+      for (size_t k=0; k+1<breaks.size(); ++k){
+        int r0 = breaks[k], r1 = breaks[k+1];
+        // tangent at i, one-sided at run ends unless the loop is smooth there
+        auto tangent = [&]( int i ){
+          bool inside = (i > r0 && i < r1) || smooth;
+          if (inside) return (P(i+1) - P(i-1)).unit();
+          if (i == r0) return rotate( (P(i+1) - P(i)).unit(), (r1 - r0 > 1) ? -turn(i+1) / 2 : 0 );
+          return rotate( (P(i) - P(i-1)).unit(), (r1 - r0 > 1) ? turn(i-1) / 2 : 0 );
+        };
+        // pieces from i to j within tolerance of every segment between
+        auto fit = [&]( int i, int j, std::vector<Piece>& out ){
+          out.clear();
+          if (j == i + 1) { Piece q; q.a = P(i); q.b = P(j); out.push_back(q); return true; }
+          auto within = [&]( const std::vector<Piece>& pieces ){
+            for (int s=i; s<j; ++s) if (Deviation( pieces, P(s), P(s+1) ) > tolerance) return false;
+            return true;
+          };
+          Piece line; line.a = P(i); line.b = P(j);
+          out.push_back( line );
+          if (within( out )) return true;
+          Piece a, b;
+          if (!Fit( P(i), tangent(i), P(j), tangent(j), a, b )) return false;
+          out.clear();
+          if (a.length() > 0) out.push_back(a);
+          if (b.length() > 0) out.push_back(b);
+          return within( out );
+        };
+        std::vector<Piece> good, trial;
+        for (int i = r0; i < r1; ){
+          fit( i, i+1, good );
+          int lo = i + 1, hi = -1;
+          for (int step = 2; ; step *= 2){
+            int j = std::min( i + step, r1 );
+            if (fit( i, j, trial )) { lo = j; good.swap( trial ); }
+            else { hi = j; break; }
+            if (j == r1) break;
+          }
+          while (hi > lo + 1){
+            int j = (lo + hi) / 2;
+            if (fit( i, j, trial )) { lo = j; good.swap( trial ); }
+            else hi = j;
+          }
+          // keep the original segments unless fewer pieces replace them
+          if ((int)good.size() >= lo - i){
+            for (int s=i; s<lo; ++s) { fit( s, s+1, trial ); result.push_back( trial[0] ); start.push_back( s % n ); }
+          } else {
+            for (size_t q=0;q<good.size();++q) { result.push_back( good[q] ); start.push_back( q == 0 ? i % n : -1 ); }
+          }
+          i = lo;
+        }
+      }
+      return result;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_BIARC_HEADER_INCLUDED */
@@ -0,0 +1,245 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccCache.hpp
+/// \brief Lock-free quote cache shared between processes
+
+#ifndef CC_CACHE_HEADER_INCLUDED
+#define CC_CACHE_HEADER_INCLUDED
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <stdexcept>
+#include <stdint.h>
+#include <string.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace cc{
+
+  /// \class SharedCache
+  /// \brief Fixed-size open-addressing hash table in a POSIX shared memory segment
+  ///
+  /// Every worker process on a host maps the same named segment, so a quote
+  /// computed by one is visible to all, and the table outlives any single
+  /// worker (until Remove() or reboot).  Slots are claimed by CAS on the key
+  /// and written under a per-slot sequence counter: readers never block and
+  /// accept a value only if the counter is even and unchanged around the read.
+  /// Entries are never evicted; inserts into a full probe window are dropped.
+  /// A 64 bit key is trusted across processes only together with the check
+  /// stored beside it, which callers compare on every hit.
+  /// The header is written by whichever process claims it; if that process
+  /// dies before the header is ready, the next to open the segment takes the
+  /// claim over (by pid, so processes must share a pid namespace).
+  class SharedCache {
+
+    public:
+
+      /// Cached quote values
+      struct Value{
+        double seconds;   ///< machine time
+        double area;      ///< padded material area
+        double cost;      ///< cost in dollars
+        uint64_t check;   ///< second, independent key of the request, for the caller to compare on a hit
+      };
+
+    private:
+
+      static_assert( ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+                     "shared memory table requires address-free atomics" );
+
+      /// Slot of the table; zero-filled memory is an empty slot
+      struct Slot{
+        std::atomic<uint64_t> key;        ///< 0 when empty
+        std::atomic<uint32_t> seq;        ///< odd while being written, 0 until first write
+        uint32_t pad;
+        std::atomic<double> seconds, area, cost;
+        std::atomic<uint64_t> check;
+      };
+
+      /// Segment header
+      struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t mask;                    ///< slots - 1
+        std::atomic<uint32_t> state;      ///< 0 new, 1 initializing, 2 ready
+        std::atomic<int32_t> owner;       ///< pid of the process writing the header, 0 if unclaimed
+      };
+
+      static constexpr uint32_t Version = 3;
+      static constexpr int MaxProbe = 32;
+
+      std::string mName;
+      size_t mBytes = 0;
+      Header * mHeader = nullptr;
+      Slot * mSlot = nullptr;
+
+      static uint64_t Nonzero( uint64_t key ) { return key ? key : 1; }
+
+    public:
+
+      /// Open (or create) the segment name ("/ccquote") with a power of two number of slots
+      SharedCache( std::string name, uint32_t slots = 1<<16 );
+
+      ~SharedCache();
+
+      SharedCache( const SharedCache& ) = delete;
+      SharedCache& operator=( const SharedCache& ) = delete;
+
+      /// Look up key
+      /// \returns true and fills value on a hit
+      bool find( uint64_t key, Value& value ) const;
+
+      /// Store value under key
+      /// \returns false if the probe window is full or the slot is being written
+      bool insert( uint64_t key, const Value& value );
+
+      /// Number of slots
+      uint32_t slots() const { return mHeader->mask + 1; }
+
+      /// Call f(key, value) for every completely written entry
+      template< class F >
+      void each( F f ) const {
+        for (uint32_t i=0;i<=mHeader->mask;++i){
+          uint64_t key = mSlot[i].key.load( std::memory_order_acquire );
+          Value v;
+          if (key && find( key, v )) f( key, v );
+        }
+      }
+
+      /// Remove a named segment (processes already mapping it keep their view)
+      static void Remove( std::string name ) { shm_unlink( name.c_str() ); }
+  };
+
+    //--------------------------------------------------------------------------
+    inline SharedCache::SharedCache( std::string name, uint32_t slots )
+    : mName(name)
+    {
+      if (slots == 0 || (slots & (slots-1)) != 0)
+        throw std::invalid_argument("Error: Shared Cache Slots Must Be A Power Of Two.");
+
+      ///1. Open or create the segment and size it (zero-filled by the kernel)
+      mBytes = sizeof(Header) + sizeof(Slot) * size_t(slots);
+      int fd = shm_open( name.c_str(), O_CREAT | O_RDWR, 0600 );
+      if (fd < 0) throw std::invalid_argument("Error: Cannot Open Shared Cache.");
+      struct stat st;
+      if (fstat(fd, &st) != 0 || (st.st_size < (off_t)mBytes && ftruncate(fd, mBytes) != 0)){
+        close(fd);
+        throw std::invalid_argument("Error: Cannot Size Shared Cache.");
+      }
+      void * mem = mmap( nullptr, mBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+      close(fd);
+      if (mem == MAP_FAILED) throw std::invalid_argument("Error: Cannot Map Shared Cache.");
+
+      mHeader = (Header*)mem;
+      mSlot = (Slot*)( (char*)mem + sizeof(Header) );
+
+      ///2. The process that claims the header writes it, the others wait for it;
+      /// a claim left by a process that died before finishing is taken over
+      int32_t self = getpid();
+      for (int round=0; round<3 && mHeader->state.load( std::memory_order_acquire ) != 2; ++round){
+        int32_t owner = mHeader->owner.load( std::memory_order_acquire );
+        bool gone = owner == 0 || (kill( owner, 0 ) != 0 && errno == ESRCH);
+        if (gone && mHeader->owner.compare_exchange_strong( owner, self )){
+          mHeader->state.store( 1, std::memory_order_relaxed );
+          memcpy( mHeader->magic, "CCQUOTE", 8 );
+          mHeader->version = Version;
+          mHeader->mask = slots - 1;
+          mHeader->state.store( 2, std::memory_order_release );
+          break;
+        }
+        // bounded wait for the owner to finish
+        for (int i=0; i<100000 && mHeader->state.load( std::memory_order_acquire ) != 2; ++i)
+          std::this_thread::yield();
+      }
+
+      ///3. Validate layout against this build
+      if ( mHeader->state.load( std::memory_order_acquire ) != 2 ||
+           memcmp(mHeader->magic, "CCQUOTE", 8) != 0 ||
+           mHeader->version != Version || mHeader->mask != slots - 1 ){
+        munmap( mem, mBytes );
+        throw std::invalid_argument("Error: Incompatible Shared Cache.");
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    inline SharedCache::~SharedCache(){
+      if (mHeader) munmap( mHeader, mBytes );
+    }
+
+    //--------------------------------------------------------------------------
+    inline bool SharedCache::find( uint64_t key, Value& value ) const {
+      key = Nonzero(key);
+      uint32_t mask = mHeader->mask;
+      for (int p=0;p<MaxProbe;++p){
+        Slot& s = mSlot[ (key + p) & mask ];
+        uint64_t k = s.key.load( std::memory_order_acquire );
+        if (k == 0) return false;
+        if (k != key) continue;
+        uint32_t before = s.seq.load( std::memory_order_acquire );
+        if (before == 0 || (before & 1)) return false;
+        value.seconds = s.seconds.load( std::memory_order_relaxed );
+        value.area = s.area.load( std::memory_order_relaxed );
+        value.cost = s.cost.load( std::memory_order_relaxed );
+        value.check = s.check.load( std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_acquire );
+        return s.seq.load( std::memory_order_relaxed ) == before;
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    inline bool SharedCache::insert( uint64_t key, const Value& value ){
+      key = Nonzero(key);
+      uint32_t mask = mHeader->mask;
+      for (int p=0;p<MaxProbe;++p){
+        Slot& s = mSlot[ (key + p) & mask ];
+        uint64_t k = s.key.load( std::memory_order_acquire );
+        if (k == 0){
+          // claim the empty slot; on failure k holds the winner's key
+          if (!s.key.compare_exchange_strong( k, key )) {
+            if (k != key) continue;
+          }
+        } else if (k != key) continue;
+
+        ///Write under the sequence counter; a concurrent writer wins
+        uint32_t seq = s.seq.load( std::memory_order_relaxed );
+        if ( (seq & 1) || !s.seq.compare_exchange_strong( seq, seq+1, std::memory_order_acquire ) )
+          return false;
+        std::atomic_thread_fence( std::memory_order_release );
+        s.seconds.store( value.seconds, std::memory_order_relaxed );
+        s.area.store( value.area, std::memory_order_relaxed );
+        s.cost.store( value.cost, std::memory_order_relaxed );
+        s.check.store( value.check, std::memory_order_relaxed );
+        s.seq.store( seq+2, std::memory_order_release );
+        return true;
+      }
+      return false;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_CACHE_HEADER_INCLUDED */
@@ -0,0 +1,214 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccCommonLine.hpp
+/// \brief Detection of straight cuts shared by neighbouring parts on a sheet
+
+#ifndef CC_COMMONLINE_HEADER_INCLUDED
+#define CC_COMMONLINE_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2, Hash
+#include "ccMacros.hpp"     //< PI
+
+namespace cc{
+
+  /// \class CommonLine
+  /// \brief Finds collinear, overlapping straight edges of different parts
+  ///
+  /// Where parts are nested edge to edge, a shared edge is cut once, so its
+  /// length is machined once rather than once per part.  Each segment is
+  /// indexed by its supporting line in a uniform grid over (angle, offset),
+  /// and sorted along the line within a cell, so only nearby segments of
+  /// neighbouring cells are compared and the detector is near linear in the
+  /// number of segments.  Segments within `tolerance` of
+  /// each other's lines are grouped, and the length covered by more than one
+  /// segment of a group is counted once per extra pass.  Only edges that
+  /// touch are shared, so parts nested with any clearance (Nest keeps
+  /// Material::Padding unless given spacing(0)) share nothing.
+  class CommonLine {
+
+      /// A segment on a sheet
+      struct Segment{
+        Vec2 a, b;
+        int part;
+        double theta;   ///< direction in [0, PI)
+        double rho;     ///< signed distance of the line from the origin
+      };
+
+      std::vector<Segment> mSegment;
+      double mTolerance = .005;
+
+      static constexpr double AngleCell = .01;   ///< radians per grid cell
+
+      /// Do two segments lie on one line (within tolerance) and overlap along it?
+      bool common( const Segment& s, const Segment& t ) const;
+
+    public:
+
+      /// Set maximum distance between edges counted as one cut
+      void tolerance( double t ) { mTolerance = t; }
+
+      /// Add a straight edge of a part, in sheet coordinates
+      void add( const Vec2& a, const Vec2& b, int part );
+
+      /// Number of segments added
+      size_t size() const { return mSegment.size(); }
+
+      /// Remove all segments
+      void clear() { mSegment.clear(); }
+
+      /// Length that need not be cut because it is shared with another part
+      /// (zero unless parts were placed edge to edge, with no spacing)
+      double shared() const;
+  };
+
+    //--------------------------------------------------------------------------
+    inline void CommonLine::add( const Vec2& a, const Vec2& b, int part ){
+      Vec2 d = b - a;
+      if (d.norm() <= mTolerance) return;
+      double theta = atan2( d.y, d.x );
+      if (theta < 0) theta += PI;
+      if (theta >= PI) theta -= PI;
+      // normal of the canonical direction
+      Vec2 n = { -sin(theta), cos(theta) };
+      mSegment.push_back( { a, b, part, theta, Vec2::Dot( n, a ) } );
+    }
+
+    //--------------------------------------------------------------------------
+    inline bool CommonLine::common( const Segment& s, const Segment& t ) const {
+      if (s.part == t.part) return false;
+      Vec2 d = (s.b - s.a).unit();
+      Vec2 n = { -d.y, d.x };
+      // both ends of t on the line of s, and the projections overlap
+      if ( fabs( Vec2::Dot( n, t.a - s.a ) ) > mTolerance ||
+           fabs( Vec2::Dot( n, t.b - s.a ) ) > mTolerance ) return false;
+      double s0 = 0, s1 = Vec2::Dot( d, s.b - s.a );
+      double t0 = Vec2::Dot( d, t.a - s.a ), t1 = Vec2::Dot( d, t.b - s.a );
+      return std::min( s1, std::max(t0, t1) ) - std::max( s0, std::min(t0, t1) ) > mTolerance;
+    }
+
+    //--------------------------------------------------------------------------
+    inline double CommonLine::shared() const {
+
+      int n = mSegment.size();
+      if (n < 2) return 0;
+
+      ///1. Grid over line space: angle cells wrap around with the offset negated.
+      /// Each cell keeps its segments sorted by where they start along the cell's axis
+      struct Cell{
+        std::vector< std::pair<double,int> > start;
+        double longest = 0;
+      };
+      int cells = (int)ceil( PI / AngleCell );
+      double rhoCell = std::max( mTolerance * 2, 1e-6 );
+      auto key = [&]( int i, long r ){
+        return Hash::Combine( Hash::Mix( (uint64_t)i ), (uint64_t)r );
+      };
+      auto axis = [&]( int i ){
+        double a = (i + .5) * AngleCell;
+        return Vec2{ cos(a), sin(a) };
+      };
+      auto span = [&]( const Segment& s, const Vec2& u, double& lo, double& hi ){
+        double p = Vec2::Dot( u, s.a ), q = Vec2::Dot( u, s.b );
+        lo = std::min(p, q); hi = std::max(p, q);
+      };
+      std::unordered_map< uint64_t, Cell > grid;
+      grid.reserve( n );
+      for (int k=0;k<n;++k){
+        auto& s = mSegment[k];
+        int i = std::min( (int)( s.theta / AngleCell ), cells - 1 );
+        double lo, hi;
+        span( s, axis(i), lo, hi );
+        auto& c = grid[ key( i, (long)floor( s.rho / rhoCell ) ) ];
+        c.start.push_back( { lo, k } );
+        c.longest = std::max( c.longest, hi - lo );
+      }
+      for (auto& c : grid) std::sort( c.second.start.begin(), c.second.start.end() );
+
+      ///2. Group common segments of neighbouring cells whose spans overlap
+      std::vector<int> parent( n );
+      for (int k=0;k<n;++k) parent[k] = k;
+      auto find = [&]( int k ){
+        while (parent[k] != k) k = parent[k] = parent[ parent[k] ];
+        return k;
+      };
+      bool any = false;
+      for (int k=0;k<n;++k){
+        auto& s = mSegment[k];
+        int i = std::min( (int)( s.theta / AngleCell ), cells - 1 );
+        for (int di=-1; di<=1; ++di){
+          int j = i + di;
+          double rho = s.rho;
+          if (j < 0 || j >= cells) { j = (j + cells) % cells; rho = -rho; }
+          long r = (long)floor( rho / rhoCell );
+          double lo, hi;
+          span( s, axis(j), lo, hi );
+          for (long dr=-1; dr<=1; ++dr){
+            auto it = grid.find( key( j, r + dr ) );
+            if (it == grid.end()) continue;
+            auto& c = it->second;
+            // segments starting before s ends, back to the longest that could reach s
+            auto end = std::upper_bound( c.start.begin(), c.start.end(), std::make_pair( hi + mTolerance, n ) );
+            for (auto e = end; e != c.start.begin(); ){
+              --e;
+              if (e->first < lo - c.longest - mTolerance) break;
+              int m = e->second;
+              if (m <= k || find(m) == find(k) || !common( s, mSegment[m] )) continue;
+              parent[ find(m) ] = find(k);
+              any = true;
+            }
+          }
+        }
+      }
+      if (!any) return 0;
+
+      ///3. In each group, length covered more than once along the group's line
+      std::unordered_map< int, std::vector<int> > groups;
+      for (int k=0;k<n;++k) groups[ find(k) ].push_back(k);
+      double result = 0;
+      for (auto& g : groups){
+        if (g.second.size() < 2) continue;
+        auto& root = mSegment[ g.first ];
+        Vec2 d = (root.b - root.a).unit();
+        std::vector< std::pair<double,int> > events;
+        for (int k : g.second){
+          double t0 = Vec2::Dot( d, mSegment[k].a - root.a );
+          double t1 = Vec2::Dot( d, mSegment[k].b - root.a );
+          events.push_back( { std::min(t0, t1), 1 } );
+          events.push_back( { std::max(t0, t1), -1 } );
+        }
+        std::sort( events.begin(), events.end() );
+        int depth = 0;
+        for (size_t e=0;e<events.size();++e){
+          if (e > 0 && depth > 1) result += (depth - 1) * ( events[e].first - events[e-1].first );
+          depth += events[e].second;
+        }
+      }
+      return result;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_COMMONLINE_HEADER_INCLUDED */
@@ -26,6 +26,9 @@
 #ifndef CC_CONSTANTS_HEADER_INCLUDED
 #define CC_CONSTANTS_HEADER_INCLUDED
 
+#include <vector>
+#include <algorithm>
+
 namespace cc{
 
   /// Costs
@@ -49,6 +52,8 @@ namespace cc{
   struct Velocity{
     /// Max Velocity
     static constexpr double Max = .5;
+    /// Rapid (non-cutting) travel between loops
+    static constexpr double Rapid = 5.0;
     /// Max Velocity weighted by exp(-(1/radius))
     static double Radius( double radius ){
       return Max * exp(-(1.0/radius));
@@ -61,6 +66,30 @@ namespace cc{
     static constexpr double Padding = .1;
   };
 
+  /// A pricing and velocity scenario (defaults to the constants above)
+  /// Arc velocity is weighted as velocity * exp(-falloff/radius)
+  struct Profile{
+    double perSecond = Cost::PerSecond;        ///< Cost per second
+    double perUnitArea = Cost::PerUnitArea;    ///< Cost per unit area
+    double velocity = Velocity::Max;           ///< Max velocity in inches per second
+    double falloff = 1.0;                      ///< Radius weighting of arc velocity
+    double padding = Material::Padding;        ///< Padding on width and height
+    double rapid = Velocity::Rapid;            ///< Travel velocity between loops
+    double acceleration = 0;                   ///< Acceleration limit in inches per second squared (0 for constant velocity)
+    double deviation = .002;                   ///< Junction deviation in inches, when acceleration is limited
+    double kerf = 0;                           ///< Cut width in inches (0 cuts along the nominal geometry)
+  };
+
+  /// Price tiers: ascending cost boundaries, tier i holding costs in [bounds[i-1], bounds[i])
+  struct Tiers{
+    std::vector<double> bounds;
+
+    /// Tier of a cost (0 below the first boundary)
+    int operator()( double cost ) const {
+      return std::upper_bound( bounds.begin(), bounds.end(), cost ) - bounds.begin();
+    }
+  };
+
 } //c::
 
 
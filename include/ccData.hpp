@@ -31,6 +31,7 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <functional>
 
 
 #include "json/json.h"      //< Parsing Library
@@ -41,6 +42,28 @@
 
 #include "ccConstants.hpp"      //< Costs information
 
+#include "ccSummary.hpp"    //< Geometry summaries
+
+#include "ccPath.hpp"       //< Loops and tool path
+
+#include "ccMotion.hpp"     //< Acceleration limited time
+
+#include "ccOffset.hpp"     //< Kerf offset
+
+#include "ccTopology.hpp"   //< ID validation
+
+#include "ccWeld.hpp"       //< Vertex welding
+
+#include "ccSimplify.hpp"   //< Hull input reduction
+
+#include "ccBiarc.hpp"      //< Arc fitting
+
+#include "ccKernel.hpp"     //< Approximate boxes
+
+#include "ccSmall.hpp"      //< Small hull kernels
+
+#include "ccShape.hpp"      //< Closed form shapes
+
 namespace cc{
 
   using std::string;
@@ -50,6 +73,27 @@ namespace cc{
   using std::stringstream;
   using std::vector;
 
+  /// A quote refined over time, with bounds certified at each step
+  struct Progress{
+    double seconds = 0;       ///< machining time (exact at every step)
+    double area = 0;          ///< lower bound of the padded box area, from the box of the points so far
+    double upper = 0;         ///< upper bound of the padded box area, from that box grown by the largest arc sagitta
+    double error = 0;         ///< relative error bound of area: (upper - area) / area
+    double cost = 0;          ///< cost at area
+    double costUpper = 0;     ///< cost at upper
+    int resolution = 1;       ///< finest steps per arc so far (0 if the budget expired before the time was known)
+    bool bCertified = false;  ///< is error within the bound asked for?
+  };
+
+  /// A quote placed in a price tier, exactly only where the tier is in doubt
+  struct Tiered{
+    int tier = 0;             ///< price tier of the cost
+    double low = 0;           ///< cost interval from box bounds (equal to cost if exact)
+    double high = 0;
+    double cost = 0;          ///< exact cost if bExact, else the middle of the interval
+    bool bExact = false;      ///< was the minimum box computed?
+  };
+
   /// \class Data
   /// \brief loads a json file into memory and runs analysis
   ///
@@ -63,8 +107,8 @@ namespace cc{
 
       /// Vertices
       vector<Vec2> mVec;
-      /// Map of Vertex ID to Vec2 Pointers
-      map<int,std::shared_ptr<Vec2>> mMap;
+      /// Vertices shared by edges: one block, pointed into by aliasing shared_ptrs
+      std::shared_ptr< vector<Vec2> > mShared;
       /// Straight Edges
       vector<Edge> mEdge;
       /// Circular Arcs
@@ -73,6 +117,49 @@ namespace cc{
       /// Number of discretization steps, default is 20
       int mResolution = 20;
 
+      /// Optional cancellation token polled during analysis
+      const Cancel * mCancel = nullptr;
+
+      /// Report on vertex and edge IDs from the last read
+      Topology mTopology;
+
+      /// Distance within which vertices are merged on read, and discretized points deduplicated
+      double mWeld = 1e-6;
+
+      /// Distance within which chains of vertices are reduced before hulling, 0 if not
+      double mSimplify = 0;
+
+      /// Closed form of a part that is one rectangle, circle or convex polygon, found on read
+      Shape mShape;
+
+      /// Loops and the tool path through them, planned on first use after each
+      /// read, fit() or change of resolution (which the holes are found at)
+      struct Route{
+        vector<Loop> loops;
+        vector<Path::Stop> stops;
+        double travel = 0;
+        bool bValid = false;
+      } mRoute;
+
+      /// Recognize a part made of one closed loop (and no other vertices) as a Shape
+      void classify();
+
+      /// Loops and their planned path, from mRoute or planned into it
+      const Route& route();
+
+      /// Time along the planned tool path, with the kerf and acceleration limits of a profile
+      double path( const Profile& f );
+
+      /// Points of loops not enclosed by others: arcs discretized in res steps,
+      /// or circumscribed within tolerance if res is 0, and chains of vertices
+      /// reduced within simplify if it is positive.  Empty if nothing is
+      /// enclosed and nothing is simplified
+      vector<Vec2> outer( int res, double tolerance, double simplify );
+
+      /// Points hull() is taken of: outer() at the resolution, simplified,
+      /// or all of discretize() if that is empty
+      vector<Vec2> cloud();
+
     public:
 
       ///Empty Constructor
@@ -89,112 +176,319 @@ namespace cc{
       /// Load json file following format of files/Schema.json
       void load(std::string filename);
 
+      /// Read json from a stream following format of files/Schema.json
+      /// (throws std::invalid_argument if an edge does not join two existing vertices)
+      void read(std::istream& stream);
+
+      /// Report on how edges connect vertices, checked by read()
+      const Topology& topology() const { return mTopology; }
+
+      /// Closed form recognized by read(), used by box(), hull(), seconds() and tier() in place of the general path
+      const Shape& shape() const { return mShape; }
+
       /// Set resolution
-      void resolution( int r ) { mResolution = r; }
+      void resolution( int r ) {
+        if (r != mResolution) mRoute = Route();
+        mResolution = r;
+      }
+
+      /// Set distance within which read() merges vertices (dropping edges
+      /// shorter than it) and discretize() drops repeated points; 0 disables
+      void weld( double tolerance ) { mWeld = tolerance; }
+
+      /// Reduce chains of vertices by Douglas–Peucker within tolerance before
+      /// hulling (0, the default, disables).  The hull then loses at most
+      /// Simplify::Bound( perimeter, tolerance ) of area, and the box at most
+      /// loss(); seconds() and outline() still use every vertex
+      void simplify( double tolerance ) { mSimplify = tolerance; }
+
+      /// Set cancellation token polled by discretize(), area() and cost()
+      /// (throws Cancelled when the token expires)
+      void cancel( const Cancel * c ) { mCancel = c; }
+
+      /// Number of points that discretize() will produce
+      size_t points() const { return mVec.size() + mCircularArc.size() * mResolution; }
 
       /// Discetize Circular Arc data
       /// \param res number of steps
       /// \returns point cloud std::vector
       vector<Vec2> discretize();
 
+      /// Convex hull of discretized data
+      /// \returns counterclockwise loop of points
+      vector<Vec2> hull();
+
+      /// Convex outline enclosing the exact geometry
+      /// \param tolerance maximum distance from arcs to the outline
+      /// \returns counterclockwise loop of points
+      vector<Vec2> outline( double tolerance );
+
       /// Area of Minimal Bounding Box
       /// \param res number of discretization steps
       /// \returns area in squared inches
       double area();
 
+      /// Area of Minimal Bounding Box padded by a profile, grown by its kerf
+      double area( const Profile& f );
+
+      /// Most the unpadded box behind area() can be short by through
+      /// simplify(): Simplify::Bound of that box (0 for closed forms, or
+      /// without simplifying)
+      double loss();
+
+      /// Approximate (unpadded) Minimal Bounding Box from a kernel of the
+      /// discretized data, for triage of huge parts
+      /// \param epsilon relative error aimed for (the guaranteed one is returned)
+      Kernel::Estimate estimate( double epsilon = .01 ){
+        return Kernel::Box( discretize(), Kernel::Cells(epsilon), mCancel );
+      }
+
       /// Time in seconds it will take to machine
-      /// \returns integrated time calculation
+      /// \returns integrated time calculation, plus rapid travel between loops
       double seconds();
 
+      /// Time in seconds at the velocities of a profile
+      /// (along the kerf offset path if f.kerf > 0, acceleration limited if f.acceleration > 0)
+      double seconds( const Profile& f );
+
       /// Estimated Cost to Manufacture
       /// \param res number of discretization steps
       /// \returns cost in dollars
       double cost();
 
+      /// Price tier of the cost under a profile: the box area is first bounded
+      /// without hulling, and the exact box is only computed when the cost
+      /// interval straddles a tier boundary or exact is asked for (or the part
+      /// has a closed form, whose box is exact and cheaper than the bounds)
+      Tiered tier( const Profile& f, const Tiers& tiers, bool exact = false );
+
+      /// Anytime quote: first from vertices alone, then doubling the steps of
+      /// arcs whose sagitta keeps the area bound loose, adding only the new
+      /// points to the previous hull, until the relative area error is within
+      /// bound or budget expires (the budget also covers the time, and with
+      /// padding the bound may be out of reach: see the implementation)
+      /// \param report called with each estimate, first to last
+      /// \returns the last estimate
+      Progress quote( const Profile& f, double bound, const Cancel& budget,
+                      std::function<void(const Progress&)> report = nullptr );
+
+      /// Estimated Cost under several pricing profiles from one geometry evaluation
+      /// \param profiles pricing and velocity scenarios
+      /// \returns cost in dollars for each profile
+      vector<double> cost( const vector<Profile>& profiles );
+
+      /// Canonical hash of the geometry
+      /// Independent of vertex and edge IDs, member order and edge direction
+      uint64_t hash() const;
+
+      /// Second digest of the geometry, canonical as hash() is but by another
+      /// function (FNV-1a, not splitmix), so that keys alike by chance under
+      /// one are told apart by the other
+      uint64_t check() const;
+
+      /// Compact summary of the geometry for repricing without reloading
+      /// \returns minimum box, straight length and arc length by radius
+      Summary summary();
+
       /// Print out stored data
       void print();
 
       /// \todo print out in post-script format
       void printPS(){}
 
+      /// Minimum Bounding Box of discretized data (unpadded)
+      Hull::Box box();
+
+      /// Straight edges as pairs of end points
+      vector< std::pair<Vec2,Vec2> > lines() const;
+
+      /// Chains of edges connected at shared vertices (closed loops and open paths),
+      /// with their areas and nesting (Loop::hole())
+      vector<Loop> loops();
+
+      /// Rapid travel distance between loops along the planned tool path
+      double travel() { return mShape.closed() ? 0 : route().travel; }
+
+      /// Edges of a loop as pieces, in its order of travel
+      vector<Piece> pieces( const Loop& l );
+
+      /// Pieces of every loop, closed loops offset away from the material by half the kerf
+      vector< vector<Piece> > contours( double kerf = 0 );
+
+      /// Replace runs of straight edges by biarcs (and collinear runs by one
+      /// line) within tolerance, keeping corners sharper than Biarc's default
+      /// \returns number of edges removed
+      int fit( double tolerance );
+
 };
 
 
     inline void Data::init(){
-      mMap.clear();
+      mShared.reset();
       mEdge.clear();
       mCircularArc.clear();
       mVec.clear();
+      mTopology = Topology();
+      mShape = Shape();
+      mRoute = Route();
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Data::classify(){
+      mShape = Shape();
+      if (!mTopology.closed() || mTopology.components != 1 || mTopology.isolated) return;
+      auto& all = route().loops;
+      if (all.size() == 1 && all[0].bClosed) mShape = Shape::Classify( pieces( all[0] ), mWeld );
     }
 
     //--------------------------------------------------------------------------
     /// Load json implementation:
     inline void Data::load(std::string filename){
 
-        init();
-
         printf("Loading Data from %s...\n", filename.c_str());
-        ///1. Load file into root
-        Json::Value root;
 	std::fstream file;
         File::Load(filename, file);
-	file >> root;
+        read(file);
+    }
+
+    //--------------------------------------------------------------------------
+    /// Read json implementation:
+    inline void Data::read(std::istream& stream){
+
+        init();
+
+        ///1. Load stream into root
+        Json::Value root;
+        stream >> root;
+
+        ///2. Validate vertex and edge IDs before building anything,
+        /// remapping vertex IDs to dense indices
+        /// (iterating members directly, rather than looking each name up again)
+        auto& vertices = root["Vertices"];
+        auto& edges = root["Edges"];
+        // Schema stores vertex and edge ids as strings
+        const char * end;
+        vector<int> ids;
+        ids.reserve(vertices.size());
+        // an ID past the range of int would alias another, so is rejected
+        auto parse = []( const char * name ){
+          int id;
+          if (!IdTable::Parse( name, id )) throw std::invalid_argument("Error: ID Out Of Range.");
+          return id;
+        };
+        for (auto i = vertices.begin(); i != vertices.end(); ++i) ids.push_back( parse( i.memberName(&end) ) );
+        vector< const Json::Value * > kept;
+        vector< vector<int> > ends;
+        vector<char> arcs;
+        kept.reserve(edges.size());
+        ends.reserve(edges.size());
+        for (auto i = edges.begin(); i != edges.end(); ++i){
+          auto type = (*i)["Type"].asString();
+          if (type != "LineSegment" && type != "CircularArc") continue;
+          parse( i.memberName(&end) );
+          kept.push_back( &*i );
+          arcs.push_back( type == "CircularArc" );
+          ends.push_back( vector<int>() );
+          for (auto& j : (*i)["Vertices"]) ends.back().push_back( j.asInt() );
+        }
+        IdTable dense;
+        mTopology = Topology::Check( ids, ends, dense, arcs );
+        mTopology.check();
 
-        ///2. Store Vertex information first
-        auto vertices = root["Vertices"];
-        // Resize std::vector of Vec2
+        ///3. Store Vertex information
         mVec.resize(vertices.size());
-        // Schema stores vertex ids as strings
         int iter = 0;
-        for (auto& i : vertices.getMemberNames()){
-          // save vertex name as int
-          stringstream os; os << i; int id; os >> id;
+        for (auto& i : vertices){
           // copy in data as doubles
-          mVec[iter] =
-            { vertices[i]["Position"]["X"].asDouble(),
-              vertices[i]["Position"]["Y"].asDouble() };
-          ///3. Store vertex id as map to pointer in memory:
-          mMap[id] = std::make_shared<Vec2>(mVec[iter]); iter++;
+          auto& p = i["Position"];
+          mVec[iter++] = { p["X"].asDouble(), p["Y"].asDouble() };
         }
 
-        ///4. Now store edge data as pointer into memory
-        auto edges = root["Edges"];
-        for (auto& i : edges.getMemberNames()){
+        ///4. Weld near-coincident vertices, and report on the welded topology
+        vector<Vec2> welded;
+        vector<int> merged = Weld::Merge( mVec, mWeld, welded );
+        int weldedCount = mVec.size() - welded.size();
+        // edges shorter than the tolerance collapse to a point, but for an arc
+        // sweeping more than a half turn, which is welded shut into a full circle
+        vector<char> shut( ends.size(), 0 );
+        for (size_t k=0;k<ends.size();++k){
+          int a = dense.find( ends[k][0] ), b = dense.find( ends[k][1] );
+          if (a == b || merged[a] != merged[b]) continue;
+          shut[k] = 1;
+          if (!arcs[k]) continue;
+          CircularArc arc;
+          // ends that already coincide are closed by this weld, so take them as one vertex
+          auto from = std::make_shared<Vec2>( mVec[a] );
+          bool same = mVec[a].x == mVec[b].x && mVec[a].y == mVec[b].y;
+          arc.mVec = { from, same ? from : std::make_shared<Vec2>( mVec[b] ) };
+          arc.mCenter = { (*kept[k])["Center"]["X"].asDouble(), (*kept[k])["Center"]["Y"].asDouble() };
+          arc.bClockwise = ends[k][0] == (*kept[k])["ClockwiseFrom"].asInt();
+          if (fabs( arc.radians() ) > PI) shut[k] = 0;
+        }
+        mVec.swap( welded );
+        vector<int> dense2( mVec.size() );
+        for (size_t k=0;k<dense2.size();++k) dense2[k] = k;
+        vector< vector<int> > ends2;
+        ends2.reserve( ends.size() );
+        for (auto& e : ends){
+          ends2.push_back( vector<int>() );
+          for (int j : e) ends2.back().push_back( merged[ dense.find(j) ] );
+        }
+        if (weldedCount > 0){
+          vector< vector<int> > live;
+          vector<char> liveArcs;
+          for (size_t k=0;k<ends2.size();++k) if (!shut[k]) { live.push_back( ends2[k] ); liveArcs.push_back( arcs[k] ); }
+          mTopology = Topology::Check( dense2, live, liveArcs );
+          mTopology.welded = weldedCount;
+          mTopology.collapsed = ends2.size() - live.size();
+        }
+
+        mShared = std::make_shared< vector<Vec2> >( mVec );
+        auto vertex = [&]( int index ){
+          return std::shared_ptr<Vec2>( mShared, &(*mShared)[ index ] );
+        };
+
+        ///5. Now store edge data as pointers into memory
+        iter = 0;
+        for (auto i = edges.begin(); i != edges.end(); ++i){
+          auto& edge = *i;
+          if (iter == (int)kept.size() || kept[iter] != &edge) continue;
+          if (shut[iter]) { iter++; continue; }
+          auto& v = ends2[iter];
+          int first = ends[iter++][0];
           // save edge name as int
-          stringstream os; os << i; int id; os >> id;
+          int id = IdTable::Parse( i.memberName(&end) );
           // check for edge type
-          if (edges[i]["Type"].asString() == "LineSegment"){
+          if (edge["Type"].asString() == "LineSegment"){
             mEdge.push_back( Edge() );
             auto& e = mEdge.back();
             // set id
             e.id = id;
-            // Use Vertex ID to look into Map of Pointers
-            for (auto& j : edges[i]["Vertices"]){
-              e.mVec.push_back( mMap[j.asInt()] );
-            }
+            // Use dense index of Vertex ID to point into shared block
+            for (int j : v) e.mVec.push_back( vertex(j) );
           }
 
-          ///5. if edge type is a circle, store center and bClockwise boolean.
-          if (edges[i]["Type"].asString() == "CircularArc"){
+          ///6. if edge type is a circle, store center and bClockwise boolean.
+          else {
             mCircularArc.push_back( CircularArc() );
             auto& a = mCircularArc.back();
             // set id
             a.id = id;
-            // Use Vertex ID to look into Map of Pointers
-            for (auto& j : edges[i]["Vertices"]){
-              a.mVec.push_back( mMap[j.asInt()] );
-            }
+            // Use dense index of Vertex ID to point into shared block
+            for (int j : v) a.mVec.push_back( vertex(j) );
             // copy in center point
             a.mCenter =
-              { edges[i]["Center"]["X"].asDouble(),
-                edges[i]["Center"]["Y"].asDouble() };
+              { edge["Center"]["X"].asDouble(),
+                edge["Center"]["Y"].asDouble() };
             // Do we move clockwise from first (compare first Vertex ID to CWFrom VertexID)
-            a.bClockwise =
-              edges[i]["Vertices"][0].asInt() == edges[i]["ClockwiseFrom"].asInt();
+            a.bClockwise = first == edge["ClockwiseFrom"].asInt();
 
           }
         }
 
+        ///7. Closed forms of simple parts
+        classify();
+
     }
 
     //--------------------------------------------------------------------------
@@ -228,15 +522,21 @@ namespace cc{
     inline vector<Vec2> Data::discretize(){
       vector< Vec2 > points = mVec;
       //Additional vertices from arc discretization
+      size_t iter = 0;
       for (auto& i : mCircularArc){
+        if (mCancel) mCancel->poll(iter++);
         auto v = i.discretize(mResolution);
         for (auto& j : v) points.push_back(j);
       }
+      //Arc ends repeat their vertices
+      Weld::Unique(points, mWeld);
       return points;
     };
 
     //--------------------------------------------------------------------------
     inline double Data::seconds(){
+      if (mShape.kind == Shape::Circle) return mShape.length / Velocity::Radius( mShape.radius );
+      if (mShape.closed()) return mShape.length / Velocity::Max;
       double secs = 0;
       // tally length of each straight edge, divided by max speed
       for (auto& i : mEdge){
@@ -248,25 +548,670 @@ namespace cc{
         if (i.mVec.size()<2) return 0;
         secs += i.length() / Velocity::Radius(i.radius());
       }
-      return secs;
+      // move between loops at rapid speed
+      return secs + travel() / Velocity::Rapid;
     }
 
     //--------------------------------------------------------------------------
-    inline double Data::area(){
-      //Point cloud with discretized curves
-      vector< Vec2 > points = discretize();
+    inline double Data::seconds( const Profile& f ){
+      if (f.acceleration > 0 || f.kerf > 0) return path(f);
+      if (mShape.kind == Shape::Circle) return mShape.length * exp( f.falloff / mShape.radius ) / f.velocity;
+      if (mShape.closed()) return mShape.length / f.velocity;
+      double secs = 0;
+      for (auto& i : mEdge){
+        if (i.mVec.size()<2) return 0;
+        secs += i.length() / f.velocity;
+      }
+      // arc velocity is f.velocity * exp(-f.falloff/radius)
+      for (auto& i : mCircularArc){
+        if (i.mVec.size()<2) return 0;
+        secs += i.length() * exp( f.falloff / i.radius() ) / f.velocity;
+      }
+      return secs + travel() / f.rapid;
+    }
+
+    //--------------------------------------------------------------------------
+    inline vector<Vec2> Data::hull(){
+      //A convex polygon is its own hull
+      if (!mShape.hull.empty()) return mShape.hull;
       //Convex hull of point cloud
-      auto hull = Hull::Convex(points);
-      auto box = Hull::MinimumBox(hull);
+      vector< Vec2 > points = cloud();
+      return Small::Convex(points, mCancel);
+    }
+
+    //--------------------------------------------------------------------------
+    inline vector<Vec2> Data::cloud(){
+      //Point cloud with discretized curves (of outer loops, if there are holes,
+      //with chains of vertices reduced if simplifying)
+      vector< Vec2 > points = outer(mResolution, 0, mSimplify);
+      if (points.empty()) points = discretize();
+      return points;
+    }
+
+    //--------------------------------------------------------------------------
+    inline vector<Vec2> Data::outline( double tolerance ){
+      vector< Vec2 > points = outer( 0, tolerance, 0 );
+      if (!points.empty()) return Small::Convex(points, mCancel);
+      points = mVec;
+      for (auto& i : mCircularArc){
+        auto v = i.circumscribe(tolerance);
+        for (auto& j : v) points.push_back(j);
+      }
+      return Small::Convex(points, mCancel);
+    }
+
+    //--------------------------------------------------------------------------
+    inline vector<Vec2> Data::outer( int res, double tolerance, double simplify ){
+      vector<Vec2> points;
+      auto& all = route().loops;
+      if (simplify <= 0 && std::none_of( all.begin(), all.end(), []( const Loop& l ){ return l.depth > 0; } )) return points;
+      int lines = mEdge.size();
+      for (auto& l : all){
+        if (l.depth > 0) continue;
+        auto chain = simplify > 0 ? Simplify::Polyline( l.points, simplify, l.bClosed ) : l.points;
+        for (auto& v : chain) points.push_back(v);
+        for (int e : l.edges){
+          int idx = e < 0 ? ~e : e;
+          if (idx < lines) continue;
+          if (mCancel) mCancel->poll( idx );
+          auto& arc = mCircularArc[idx - lines];
+          auto v = res > 0 ? arc.discretize(res) : arc.circumscribe(tolerance);
+          for (auto& j : v) points.push_back(j);
+        }
+      }
+      if (res > 0) Weld::Unique(points, mWeld);
+      return points;
+    }
+
+    //--------------------------------------------------------------------------
+    inline Hull::Box Data::box(){
+      if (mShape.closed()) return mShape.box(mCancel);
+      return Small::MinimumBox(hull(), mCancel);
+    }
+
+    //--------------------------------------------------------------------------
+    inline vector< std::pair<Vec2,Vec2> > Data::lines() const {
+      vector< std::pair<Vec2,Vec2> > result;
+      result.reserve( mEdge.size() );
+      for (auto& i : mEdge){
+        if (i.mVec.size() > 1 && i.mVec[0] && i.mVec[1]) result.push_back( { *i.mVec[0], *i.mVec[1] } );
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /// Loop extraction implementation:
+    /// edges sharing a vertex ID share its pointer, so chains are walked
+    /// through a map of vertex pointer to incident edges, open chains first
+    /// (from vertices not of degree two), then the remaining closed loops
+    inline vector<Loop> Data::loops(){
+
+      ///1. Every valid edge as a link between two vertex pointers
+      /// (edges are numbered straight edges first, then arcs)
+      struct Link{ const Vec2 * a; const Vec2 * b; double length; int edge; };
+      vector<Link> links;
+      links.reserve( mEdge.size() + mCircularArc.size() );
+      for (size_t i=0;i<mEdge.size();++i){
+        auto& e = mEdge[i];
+        if (e.mVec.size() > 1 && e.mVec[0] && e.mVec[1]) links.push_back( { e.mVec[0].get(), e.mVec[1].get(), e.length(), (int)i } );
+      }
+      for (size_t i=0;i<mCircularArc.size();++i){
+        auto& e = mCircularArc[i];
+        if (e.mVec.size() > 1 && e.mVec[0] && e.mVec[1]) links.push_back( { e.mVec[0].get(), e.mVec[1].get(), e.length(), (int)(mEdge.size() + i) } );
+      }
+      // links at each vertex of the shared block, in compressed rows
+      int nv = mShared ? mShared->size() : 0;
+      auto index = [&]( const Vec2 * v ){ return (int)( v - mShared->data() ); };
+      vector<int> offset( nv + 1, 0 ), incident( 2 * links.size() );
+      for (auto& l : links) { offset[ index(l.a) + 1 ]++; offset[ index(l.b) + 1 ]++; }
+      for (int i=0;i<nv;++i) offset[i+1] += offset[i];
+      {
+        vector<int> fill( offset.begin(), offset.end() - 1 );
+        for (int k=0;k<(int)links.size();++k){
+          incident[ fill[ index(links[k].a) ]++ ] = k;
+          incident[ fill[ index(links[k].b) ]++ ] = k;
+        }
+      }
+
+      ///2. Walk chains, marking links as used
+      vector<bool> used( links.size(), false );
+      vector<Loop> result;
+      auto walk = [&]( const Vec2 * start ){
+        Loop l;
+        bool any = false;
+        const Vec2 * v = start;
+        l.points.push_back( *v );
+        for (;;){
+          int next = -1;
+          int i = index(v);
+          for (int j=offset[i]; j<offset[i+1]; ++j) if (!used[ incident[j] ]) { next = incident[j]; break; }
+          if (next < 0) break;
+          used[next] = true;
+          any = true;
+          l.length += links[next].length;
+          l.edges.push_back( links[next].a == v ? links[next].edge : ~links[next].edge );
+          v = (links[next].a == v) ? links[next].b : links[next].a;
+          if (v == start) { l.bClosed = true; break; }
+          l.points.push_back( *v );
+        }
+        if (any) result.push_back( l );
+        return any;
+      };
+      for (int i=0;i<nv;++i) if (offset[i+1] - offset[i] != 2) while (walk( &(*mShared)[i] )) {}
+      for (int i=0;i<nv;++i) while (walk( &(*mShared)[i] )) {}
+
+      ///3. Areas, and holes from containment of the closed loops as polygons
+      vector< vector<Vec2> > polygons( result.size() );
+      for (size_t k=0;k<result.size();++k){
+        if (mCancel) mCancel->poll(k);
+        auto& l = result[k];
+        if (!l.bClosed) continue;
+        auto p = pieces(l);
+        l.area = Offset::Area(p);
+        if (result.size() < 2) continue;
+        for (auto& i : p){
+          polygons[k].push_back( i.a );
+          if (!i.arc()) continue;
+          int steps = std::max( 1, (int)ceil( fabs(i.sweep) / (2*PI) * mResolution ) );
+          double start = Vec2::Theta( i.a - i.center ), r = i.radius();
+          for (int j=1;j<steps;++j) polygons[k].push_back( Vec2::Construct( i.center, start + i.sweep * j / steps, r ) );
+        }
+      }
+      Path::Classify( result, polygons );
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    inline const Data::Route& Data::route(){
+      if (mRoute.bValid) return mRoute;
+      Route r;
+      r.loops = loops();
+      r.stops = Path::Plan( r.loops );
+      r.travel = Path::Travel( r.stops );
+      r.bValid = true;
+      mRoute = std::move(r);
+      return mRoute;
+    }
+
+    //--------------------------------------------------------------------------
+    inline vector<Piece> Data::pieces( const Loop& l ){
+      vector<Piece> result;
+      result.reserve( l.edges.size() );
+      int lines = mEdge.size();
+      for (int e : l.edges){
+        int idx = e < 0 ? ~e : e;
+        Piece p;
+        if (idx < lines){
+          p.a = *mEdge[idx].mVec[0]; p.b = *mEdge[idx].mVec[1];
+        } else {
+          auto& i = mCircularArc[idx - lines];
+          p.a = *i.mVec[0]; p.b = *i.mVec[1];
+          p.center = i.mCenter;
+          p.sweep = i.radians();
+        }
+        result.push_back( e < 0 ? p.reversed() : p );
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /// Biarc fitting implementation:
+    /// runs of straight edges along each loop are refitted as pieces whose
+    /// ends are the run's vertices or new joints; arcs are kept, and every
+    /// edge is then rebuilt over a new shared block of the vertices still used
+    inline int Data::fit( double tolerance ){
+
+      if (!mShared || tolerance <= 0) return 0;
+      int lines = mEdge.size(), before = mEdge.size() + mCircularArc.size();
+      auto index = [&]( const Vec2 * v ){ return (int)( v - mShared->data() ); };
+
+      ///1. Edges to build, by vertex index (new joints numbered after the old vertices)
+      struct Rebuilt{ int a, b; bool arc, cw; Vec2 center; int id; };
+      vector<Rebuilt> rebuilt;
+      vector<Vec2> block = *mShared;
+      int nextId = 0;
+      for (auto& e : mEdge) nextId = std::max( nextId, e.id + 1 );
+      for (auto& e : mCircularArc) nextId = std::max( nextId, e.id + 1 );
+
+      for (auto& l : loops()){
+        int m = l.edges.size();
+        // oriented ends of each edge of the loop
+        vector<int> from( m ), to( m );
+        for (int k=0;k<m;++k){
+          int e = l.edges[k], idx = e < 0 ? ~e : e;
+          auto& v = idx < lines ? mEdge[idx].mVec : mCircularArc[idx - lines].mVec;
+          from[k] = index( v[ e < 0 ? 1 : 0 ].get() );
+          to[k] = index( v[ e < 0 ? 0 : 1 ].get() );
+        }
+        auto straight = [&]( int k ){ int e = l.edges[k]; return (e < 0 ? ~e : e) < lines; };
+
+        // runs of straight edges: [first, first+count) cyclically
+        int first = 0;
+        bool all = true;
+        for (int k=0;k<m;++k) if (!straight(k)) { all = false; first = (k + 1) % m; break; }
+        if (!l.bClosed) first = 0;
+        for (int k=0;k<m;){
+          int s = (first + k) % m;
+          if (!straight(s)){
+            int e = l.edges[s];
+            auto& arc = mCircularArc[ (e < 0 ? ~e : e) - lines ];
+            rebuilt.push_back( { index( arc.mVec[0].get() ), index( arc.mVec[1].get() ), true, arc.bClockwise, arc.mCenter, arc.id } );
+            ++k; continue;
+          }
+          int count = 0;
+          while (k + count < m && straight( (first + k + count) % m )) ++count;
+          bool closed = all && l.bClosed;
+          vector<Vec2> chain;
+          vector<int> vertex, edge;
+          for (int c=0;c<count;++c){
+            int t = (first + k + c) % m;
+            vertex.push_back( from[t] );
+            edge.push_back( l.edges[t] );
+          }
+          if (!closed) vertex.push_back( to[ (first + k + count - 1) % m ] );
+          for (int v : vertex) chain.push_back( block[v] );
+          vector<int> start;
+          auto pieces = Biarc::Polyline( chain, closed, tolerance, start );
+          // a closed chain with corners is covered from its first corner, and back to it
+          int n = chain.size(), at = pieces.empty() ? vertex[0] : vertex[ start[0] ];
+          for (size_t p=0;p<pieces.size();++p){
+            int a = at, b;
+            if (p + 1 < pieces.size() && start[p+1] < 0) { b = block.size(); block.push_back( pieces[p].b ); }
+            else if (p + 1 < pieces.size()) b = vertex[ start[p+1] ];
+            else b = closed ? vertex[ start[0] ] : vertex[n-1];
+            // a segment left as it was keeps its edge
+            int id = nextId;
+            if (!pieces[p].arc() && start[p] >= 0 && start[p] < count && b == vertex[ (start[p] + 1) % n ]){
+              int e = edge[ start[p] ];
+              id = mEdge[ e < 0 ? ~e : e ].id;
+            } else nextId++;
+            auto& q = pieces[p];
+            rebuilt.push_back( { a, b, q.arc(), q.sweep < 0, q.center, id } );
+            at = b;
+          }
+          k += count;
+        }
+      }
+
+      ///2. New shared block of the vertices still used (and isolated ones)
+      vector<int> degree( block.size(), 0 ), remap( block.size(), -1 );
+      for (auto& r : rebuilt) { degree[r.a]++; degree[r.b]++; }
+      vector<bool> used( mShared->size(), false );
+      for (auto& e : mEdge) { used[ index( e.mVec[0].get() ) ] = used[ index( e.mVec[1].get() ) ] = true; }
+      for (auto& e : mCircularArc) { used[ index( e.mVec[0].get() ) ] = used[ index( e.mVec[1].get() ) ] = true; }
+      mVec.clear();
+      for (size_t i=0;i<block.size();++i){
+        if (degree[i] == 0 && i < used.size() && used[i]) continue;
+        remap[i] = mVec.size();
+        mVec.push_back( block[i] );
+      }
+      mShared = std::make_shared< vector<Vec2> >( mVec );
+      auto vertex = [&]( int i ){ return std::shared_ptr<Vec2>( mShared, &(*mShared)[ remap[i] ] ); };
+
+      ///3. Rebuild edges, straight ones first
+      mEdge.clear();
+      mCircularArc.clear();
+      vector<int> ids( mVec.size() );
+      vector< vector<int> > ends;
+      vector<char> arcs;
+      for (size_t i=0;i<ids.size();++i) ids[i] = i;
+      for (auto& r : rebuilt){
+        ends.push_back( { remap[r.a], remap[r.b] } );
+        arcs.push_back( r.arc );
+        if (r.arc) continue;
+        mEdge.push_back( Edge() );
+        mEdge.back().id = r.id;
+        mEdge.back().mVec = { vertex(r.a), vertex(r.b) };
+      }
+      for (auto& r : rebuilt){
+        if (!r.arc) continue;
+        mCircularArc.push_back( CircularArc() );
+        auto& a = mCircularArc.back();
+        a.id = r.id;
+        a.mVec = { vertex(r.a), vertex(r.b) };
+        a.mCenter = r.center;
+        a.bClockwise = r.cw;
+      }
+      int welded = mTopology.welded, collapsed = mTopology.collapsed;
+      mTopology = Topology::Check( ids, ends, arcs );
+      mTopology.welded = welded;
+      mTopology.collapsed = collapsed;
+      mRoute = Route();
+      classify();
+      return before - (int)( mEdge.size() + mCircularArc.size() );
+    }
+
+    //--------------------------------------------------------------------------
+    inline vector< vector<Piece> > Data::contours( double kerf ){
+      vector< vector<Piece> > result;
+      for (auto& l : route().loops){
+        auto p = pieces(l);
+        // outer boundaries grow, holes shrink
+        double d = l.hole() ? -kerf / 2.0 : kerf / 2.0;
+        result.push_back( (l.bClosed && kerf > 0) ? Offset::Loop( p, d ) : p );
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /// Path implementation:
+    /// loops are cut in planned order from their planned entries, offset by
+    /// half the kerf; arcs cut at the profile's weighted arc velocity, and the
+    /// corner arcs of an offset at full velocity (the model has no corner cost
+    /// unless acceleration is limited, when arcs are also capped by
+    /// centripetal acceleration)
+    inline double Data::path( const Profile& f ){
+
+      auto& loops = route().loops;
+      auto& stops = route().stops;
+      Motion m( f.acceleration, f.deviation );
+      double secs = 0;
+
+      size_t iter = 0;
+      for (auto& s : stops){
+        if (mCancel) mCancel->poll(iter++);
+        auto& l = loops[s.loop];
+        auto p = pieces(l);
+
+        ///1. Start at the planned entry
+        if (l.bClosed){
+          for (int k=0;k<(int)l.points.size();++k){
+            if (l.points[k] == s.in) { std::rotate( p.begin(), p.begin() + k, p.end() ); break; }
+          }
+          if (f.kerf > 0) p = Offset::Loop( p, l.hole() ? -f.kerf / 2.0 : f.kerf / 2.0 );
+        } else if (!(l.points.front() == s.in)){
+          std::reverse( p.begin(), p.end() );
+          for (auto& i : p) i = i.reversed();
+        }
+
+        ///2. Time each piece, or queue it as a move
+        m.stop();
+        for (auto& i : p){
+          double v = (i.arc() && !i.bJoin) ? f.velocity * exp( -f.falloff / i.radius() ) : f.velocity;
+          if (f.acceleration > 0){
+            if (i.arc()) v = m.arc( v, i.radius() );
+            m.add( i.length(), v, i.tangent(i.a), i.tangent(i.b) );
+          } else secs += i.length() / v;
+        }
+      }
+      if (f.acceleration > 0) secs = m.seconds();
+      return secs + route().travel / f.rapid;
+    }
+
+    //--------------------------------------------------------------------------
+    inline double Data::area(){
+      auto box = this->box();
       //multiply padded width and height
       return (box.width + Material::Padding ) * (box.height+Material::Padding);
     }
 
+    //--------------------------------------------------------------------------
+    inline double Data::area( const Profile& f ){
+      auto box = this->box();
+      // the outer loop offset by half the kerf grows any box by the kerf
+      return (box.width + f.kerf + f.padding) * (box.height + f.kerf + f.padding);
+    }
+
+    //--------------------------------------------------------------------------
+    inline double Data::loss(){
+      if (mSimplify <= 0 || mShape.closed()) return 0;
+      return Simplify::Bound( box(), mSimplify );
+    }
+
+    //--------------------------------------------------------------------------
+    /// Tier implementation:
+    /// the minimum box has sides w, h with wh within the area bounds and each
+    /// side at most the diameter D, so with padding p its padded area
+    /// (w + p)(h + p) lies between lower + 2p sqrt(lower) + p^2 (as w + h >=
+    /// 2 sqrt(wh)) and upper + p (D + upper / D) + p^2.  The bounds are of
+    /// the points hull() is taken of, so that they hold the box that area()
+    /// prices, holes and simplification included
+    inline Tiered Data::tier( const Profile& f, const Tiers& tiers, bool exact ){
+
+      Tiered t;
+      double secs = seconds(f) * f.perSecond;
+      double p = f.kerf + f.padding;
+
+      // bounds from the discretized points would not hold a circle's box of 2r
+      if (!exact && !mShape.closed()){
+        double lower, upper, D;
+        Kernel::Bounds( cloud(), lower, upper, D );
+        if (D > 0){
+          t.low = secs + ( lower + 2*p*sqrt(lower) + p*p ) * f.perUnitArea;
+          t.high = secs + ( upper + p * (D + upper / D) + p*p ) * f.perUnitArea;
+          t.cost = (t.low + t.high) / 2;
+          t.tier = tiers( t.low );
+          if (tiers( t.high ) == t.tier) return t;
+        }
+      }
+      t.bExact = true;
+      t.cost = t.low = t.high = secs + area(f) * f.perUnitArea;
+      t.tier = tiers( t.cost );
+      return t;
+    }
+
+    //--------------------------------------------------------------------------
+    /// Progressive quote implementation:
+    /// every point on an arc is within its sagitta (the greatest distance of
+    /// the arc from a chord between steps) of the hull of its steps, so the
+    /// hull grown by the largest sagitta contains the part, and its minimum
+    /// box w x h grown by twice that, of area U and diagonal D, bounds the true
+    /// box from above.  The true box holds the steps, so its sides have a
+    /// product between wh and U, each at most D, and are padded as in tier()
+    inline Progress Data::quote( const Profile& f, double bound, const Cancel& budget,
+                                 std::function<void(const Progress&)> report ){
+
+      Progress p;
+      p.resolution = 0;
+
+      ///0. Time, under the budget like the rest
+      const Cancel * cancel = mCancel;
+      mCancel = &budget;
+      try {
+        budget.check();
+        p.seconds = seconds(f);
+      } catch (Cancelled&) {
+        mCancel = cancel;
+        return p;
+      }
+      mCancel = cancel;
+      p.resolution = 1;
+
+      ///1. Vertices first (arc ends among them), one step per arc
+      int n = mCircularArc.size();
+      vector<int> res( n, 1 );
+      auto sagitta = [&]( int i ){
+        auto& a = mCircularArc[i];
+        double t = fabs( a.radians() ) / res[i], r = a.radius();
+        return t <= PI ? r * (1 - cos(t / 2)) : 2 * r;
+      };
+      vector<Vec2> points = mVec;
+      vector<Vec2> hull = Small::Convex( points );
+      double W = 0, H = 0, pad = f.kerf + f.padding;
+      auto evaluate = [&]{
+        double d = 0;
+        for (int i=0;i<n;++i) d = std::max( d, sagitta(i) );
+        Hull::Box box = Small::MinimumBox( hull );
+        // a hull of two points is a segment, whose box has no height
+        if (hull.size() < 3) { box.width = hull.size() == 2 ? Vec2::Dist( hull[0], hull[1] ) : 0; box.height = 0; }
+        W = box.width;
+        H = box.height;
+        double lower = W * H, upper = (W + 2*d) * (H + 2*d), D = hypot( W + 2*d, H + 2*d );
+        p.area = lower + 2*pad*sqrt(lower) + pad*pad;
+        p.upper = upper + (D > 0 ? pad * (D + upper / D) : 0) + pad*pad;
+        p.error = p.area > 0 ? (p.upper - p.area) / p.area : 0;
+        p.cost = p.seconds * f.perSecond + p.area * f.perUnitArea;
+        p.costUpper = p.seconds * f.perSecond + p.upper * f.perUnitArea;
+        p.bCertified = p.error <= bound;
+        if (report) report(p);
+      };
+      evaluate();
+
+      ///2. Refine arcs looser than the sagitta the bound allows, until certified or out of time
+      ///   (padding leaves a gap between its bounds, of D + U/D against 2 sqrt(wh),
+      ///   that no refinement closes, so refining stops once the unpadded box is within bound)
+      try {
+        while (!p.bCertified && !budget.expired() && p.resolution < (1 << 20)){
+          // (W + 2d)(H + 2d) = (1 + bound) W H
+          double need = ( -(W + H) + sqrt( (W + H) * (W + H) + 4 * bound * W * H ) ) / 4;
+          vector<Vec2> next = hull;
+          for (int i=0;i<n;++i){
+            if (sagitta(i) <= need) continue;
+            auto& a = mCircularArc[i];
+            double theta = a.radians(), start = Vec2::Theta( *a.mVec[0] - a.mCenter ), r = a.radius();
+            res[i] *= 2;
+            p.resolution = std::max( p.resolution, res[i] );
+            // the new steps fall halfway between the old ones
+            for (int k=1;k<res[i];k+=2) next.push_back( Vec2::Construct( a.mCenter, start + theta * k / res[i], r ) );
+          }
+          if (next.size() == hull.size()) break;
+          hull = Small::Convex( next, &budget );
+          evaluate();
+        }
+      } catch (Cancelled&) {}
+      return p;
+    }
+
     //--------------------------------------------------------------------------
     inline double Data::cost(){
       return seconds() * Cost::PerSecond + area() * Cost::PerUnitArea;
     }
 
+    //--------------------------------------------------------------------------
+    /// Multiple profiles implementation:
+    /// geometry (hull, box, lengths, radii) is evaluated once, then each
+    /// arc's time term is accumulated across all profiles in a contiguous loop
+    inline vector<double> Data::cost( const vector<Profile>& profiles ){
+
+      const int np = profiles.size();
+      vector<double> result(np);
+      if (np == 0) return result;
+
+      ///1. Single geometry evaluation
+      auto box = this->box();
+
+      ///2. Straight length is shared by all profiles
+      bool valid = true;
+      double straight = 0;
+      for (auto& i : mEdge){
+        if (i.mVec.size()<2) { valid = false; break; }
+        straight += i.length();
+      }
+
+      double rapid = valid ? travel() : 0;
+
+      ///3. Profile parameters as contiguous arrays
+      vector<double> falloff(np), weighted(np, straight);
+      for (int p=0;p<np;++p) falloff[p] = profiles[p].falloff;
+
+      ///4. Per arc: length * exp(falloff/radius), vectorized across profiles
+      for (auto& i : mCircularArc){
+        if (!valid) break;
+        if (i.mVec.size()<2) { valid = false; break; }
+        double len = i.length();
+        double inv = 1.0 / i.radius();
+        for (int p=0;p<np;++p){
+          weighted[p] += len * exp( falloff[p] * inv );
+        }
+      }
+
+      ///5. Combine time and material terms
+      for (int p=0;p<np;++p){
+        auto& f = profiles[p];
+        double secs = valid ? weighted[p] / f.velocity + rapid / f.rapid : 0;
+        if (valid && (f.acceleration > 0 || f.kerf > 0)) secs = path(f);
+        double area = (box.width + f.kerf + f.padding) * (box.height + f.kerf + f.padding);
+        result[p] = secs * f.perSecond + area * f.perUnitArea;
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /// Canonical hash implementation:
+    /// each vertex and edge is hashed from its coordinates alone, with edge
+    /// endpoints put in Vec2::operator< order (flipping an arc's direction to
+    /// match), and the per-element hashes are summed so order does not matter
+    inline uint64_t Data::hash() const {
+
+      auto point = [](const Vec2& v){
+        return Hash::Combine( Hash::Of(v.x), Hash::Of(v.y) );
+      };
+
+      uint64_t vertices = 0;
+      for (auto& i : mVec) vertices += point(i);
+
+      uint64_t edges = 0;
+      for (auto& i : mEdge){
+        if (i.mVec.size()<2) continue;
+        Vec2 a = *i.mVec[0], b = *i.mVec[1];
+        if (b < a) std::swap(a,b);
+        edges += Hash::Combine( point(a), point(b) );
+      }
+
+      uint64_t arcs = 0;
+      for (auto& i : mCircularArc){
+        if (i.mVec.size()<2) continue;
+        Vec2 a = *i.mVec[0], b = *i.mVec[1];
+        bool cw = i.bClockwise;
+        if (b < a) { std::swap(a,b); cw = !cw; }
+        uint64_t h = Hash::Combine( point(a), point(b) );
+        h = Hash::Combine( h, point(i.mCenter) );
+        arcs += Hash::Combine( h, cw );
+      }
+
+      return Hash::Combine( Hash::Combine( Hash::Mix(vertices), Hash::Mix(edges) ), Hash::Mix(arcs) );
+    }
+
+    //--------------------------------------------------------------------------
+    inline uint64_t Data::check() const {
+
+      // FNV-1a of coordinates (-0 and 0 alike), summed so order does not matter
+      auto bytes = []( double * c, size_t n ){
+        for (size_t i=0;i<n;++i) c[i] += 0.0;
+        return Hash::Bytes( c, n * sizeof(double) );
+      };
+
+      uint64_t vertices = 0, edges = 0, arcs = 0;
+      for (auto& i : mVec){
+        double c[] = { i.x, i.y };
+        vertices += bytes( c, 2 );
+      }
+      for (auto& i : mEdge){
+        if (i.mVec.size()<2) continue;
+        Vec2 a = *i.mVec[0], b = *i.mVec[1];
+        if (b < a) std::swap(a,b);
+        double c[] = { a.x, a.y, b.x, b.y };
+        edges += bytes( c, 4 );
+      }
+      for (auto& i : mCircularArc){
+        if (i.mVec.size()<2) continue;
+        Vec2 a = *i.mVec[0], b = *i.mVec[1];
+        bool cw = i.bClockwise;
+        if (b < a) { std::swap(a,b); cw = !cw; }
+        double c[] = { a.x, a.y, b.x, b.y, i.mCenter.x, i.mCenter.y, cw ? 1.0 : 0.0 };
+        arcs += bytes( c, 7 );
+      }
+
+      uint64_t all[6] = { vertices, edges, arcs, mVec.size(), mEdge.size(), mCircularArc.size() };
+      return Hash::Bytes( all, sizeof(all) );
+    }
+
+    //--------------------------------------------------------------------------
+    inline Summary Data::summary(){
+      Summary s;
+      auto box = this->box();
+      s.width = box.width;
+      s.height = box.height;
+      for (auto& i : mEdge){
+        if (i.mVec.size()>1) s.straight += i.length();
+      }
+      for (auto& i : mCircularArc){
+        if (i.mVec.size()>1) s.add( i.length(), i.radius() );
+      }
+      s.travel = travel();
+      return s;
+    }
+
 } //cc::
 
 
@@ -28,9 +28,78 @@
 #include <math.h>
 #include <memory>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <stdint.h>
+#include <string.h>
 
 namespace cc{
 
+  /// 64 bit hashing helpers for canonical geometry keys
+  struct Hash{
+
+    /// Finalizer of splitmix64
+    static uint64_t Mix( uint64_t h ){
+      h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+      h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+      return h ^ (h >> 31);
+    }
+
+    /// Hash of a double's bits (-0 and 0 hash alike)
+    static uint64_t Of( double d ){
+      d += 0.0;
+      uint64_t bits; memcpy(&bits, &d, sizeof(bits));
+      return Mix(bits);
+    }
+
+    /// Order dependent combination
+    static uint64_t Combine( uint64_t a, uint64_t b ){
+      return Mix( a ^ (b + 0x9e3779b97f4a7c15ULL + (a << 6) + (a >> 2)) );
+    }
+
+    /// FNV-1a of a block of memory (checksums)
+    static uint64_t Bytes( const void * data, size_t n ){
+      const unsigned char * c = (const unsigned char*)data;
+      uint64_t h = 0xcbf29ce484222325ULL;
+      for (size_t i=0;i<n;++i) { h ^= c[i]; h *= 0x100000001b3ULL; }
+      return h;
+    }
+  };
+
+  /// Thrown when a computation is abandoned through a Cancel token
+  struct Cancelled : std::runtime_error {
+    Cancelled() : std::runtime_error("Error: Computation Cancelled.") {}
+  };
+
+  /// Cooperative cancellation token: an explicit flag, an optional deadline,
+  /// and an optional parent token it expires with
+  struct Cancel{
+
+    typedef std::chrono::steady_clock Clock;
+
+    std::atomic<bool> bCancelled;     ///< set by cancel()
+    Clock::time_point deadline;       ///< expire after this time
+    const Cancel * parent;            ///< expire with this token too (may be null)
+
+    Cancel( Clock::time_point d = Clock::time_point::max(), const Cancel * p = nullptr )
+    : bCancelled(false), deadline(d), parent(p) {}
+
+    /// Request cancellation from another thread
+    void cancel() { bCancelled = true; }
+
+    /// Has this token (or its parent) been cancelled or passed its deadline?
+    bool expired() const {
+      return bCancelled.load(std::memory_order_relaxed) || Clock::now() > deadline || (parent && parent->expired());
+    }
+
+    /// Throw Cancelled if expired
+    void check() const { if (expired()) throw Cancelled(); }
+
+    /// Cheap check for inner loops: only tests every 1024th iteration
+    void poll( size_t i ) const { if ((i & 1023) == 0) check(); }
+  };
+
   /// 2D Vector which coordinates stored as doubles
   struct Vec2{
 
@@ -132,10 +201,12 @@ namespace cc{
     /// Does Arc move Clockwise from First Vec2?
     bool bClockwise;
 
-    /// Radians of arc
+    /// Radians of arc: a full turn if both ends are one vertex (drawn on one
+    /// ID, or welded shut), none if they are distinct vertices that coincide
     double radians(){                                                                     /// Output Range:
       double t = Vec2::Theta((*mVec[0] - mCenter) ,(*mVec[1] - mCenter));                 ///<-- [-PI,PI]
-      t = (t>=0) ? t : PI + (PI-t);                                                       ///<-- [0,2PI]
+      if (t == 0) return mVec[0] != mVec[1] ? 0 : bClockwise ? -2*PI : 2*PI;              ///<-- on one vertex: a full circle
+      t = (t>=0) ? t : 2*PI + t;                                                          ///<-- [0,2PI]
       if (bClockwise) t = -(2*PI-t);                                                      ///<-- [-2PI,2PI]
       return t;
     }
@@ -163,6 +234,26 @@ namespace cc{
         }
         return result;
     }
+
+    /// Points of a polyline enclosing the arc from outside, within tolerance
+    /// (endpoints, then corners where tangents at n evenly spaced angles meet)
+    std::vector<Vec2> circumscribe(double tolerance){
+        double theta = radians();
+        double start = Vec2::Theta( (*mVec[0] - mCenter) );
+        double r = radius();
+        // largest step whose tangent corners stay within tolerance of the arc
+        double step = 2.0 * acos( r / (r + tolerance) );
+        int n = (step > 0) ? (int)ceil( fabs(theta) / step ) : 1;
+        if (n < 1) n = 1;
+        double dt = theta / n;
+        double R = r / cos( dt / 2.0 );
+        std::vector<Vec2> result;
+        result.reserve(n+2);
+        result.push_back( *mVec[0] );
+        for (int i=0;i<n;++i) result.push_back( Vec2::Construct(mCenter, start + dt*(i+0.5), R) );
+        result.push_back( *mVec[1] );
+        return result;
+    }
   };
 
   /// Analysis of point cloud data
@@ -179,9 +270,10 @@ namespace cc{
       /// Create Convex hull with the Monotone Chain Algorithm
       /// \param input reference to std::vector< Vec2 >.
       /// (Passed by reference because these are sorted in place)
+      /// \param cancel optional token polled inside the loops
       /// \returns std::vector<Vec2> an ordered, convex, closed loop of points
       /// \todo consider parallel sort
-      static std::vector<Vec2> Convex( std::vector<Vec2>& input ){
+      static std::vector<Vec2> Convex( std::vector<Vec2>& input, const Cancel * cancel = nullptr ){
 
         std::vector<Vec2> result;
         std::vector<Vec2> upper;
@@ -189,9 +281,11 @@ namespace cc{
 
         ///1. sort by x and then by y (uses Vec2::operator < (...))
         std::sort( input.begin(), input.end() );
+        if (cancel) cancel->check();
 
         ///2. calculate lower hull
         for (int i=0;i<input.size();++i){
+            if (cancel) cancel->poll(i);
 
             while(  lower.size() >= 2 &&
                     Vec2::Cross(lower[lower.size()-1] - lower[lower.size()-2],
@@ -204,6 +298,7 @@ namespace cc{
 
         ///3. calculate upper hull
         for (int i=input.size()-1; i>=0;--i){
+            if (cancel) cancel->poll(i);
 
             while(  upper.size() >= 2 &&
                     Vec2::Cross(upper[upper.size()-1] - upper[upper.size()-2],
@@ -225,8 +320,9 @@ namespace cc{
 
       /// Find Minimum Bounding Box using "Rotating Calipers"
       /// \param input a convex hull
+      /// \param cancel optional token polled each rotation
       /// \return Box coordinates of minimum bounding box
-      static Box MinimumBox( const std::vector<Vec2> input){
+      static Box MinimumBox( const std::vector<Vec2> input, const Cancel * cancel = nullptr ){
 
           Box box; //< here we will store bounding box data
           if (input.size() < 3 ) return box;
@@ -253,29 +349,39 @@ namespace cc{
             if (tmaxY.y > maxY.y) { maxY = tmaxY; idx[3]=i; }
           }
 
-          // store next idx of minX
-          int loopIdx = idx[0]+1;
-
           /// 3. Calculate starting area
           Vec2 hx = input[idx[1]] - input[idx[0]];
           double width = fabs( Vec2::Cross(para[0],hx) );
           Vec2 hy = input[idx[3]] - input[idx[2]];
           double height = fabs( Vec2::Cross(para[2],hy) );
           double minArea = width*height;
+          // the axis aligned box stands unless a rotation beats it
+          box.width = width;
+          box.height = height;
+          for (int j=0;j<4;++j){
+            box.para[j] = para[j];
+            box.idx[j] = idx[j];
+          }
 
-          /// 4. Rotate Calipers in search of minimum area
+          /// 4. Rotate Calipers in search of minimum area, through a quarter turn
+          // (the four lines then lie where they started, turned by one place)
+          size_t iter = 0;
+          double turned = 0;
           do {
+            if (cancel) cancel->poll(iter++);
             // Find minimum radians we can rotate parallel lines around convex hull
+            // (atan2, as turns past a right angle occur on hulls of few points)
             minTheta = PI;
             for (int i =0;i<4;++i){
                int next = (idx[i] < (input.size() -1) ) ? idx[i]+1 : 0;
                cc::Vec2 edge = (input[next] - input[idx[i]]).unit();
-               theta[i] = asin( Vec2::Cross( para[i], edge ) );
+               theta[i] = std::max( 0.0, atan2( Vec2::Cross( para[i], edge ), Vec2::Dot( para[i], edge ) ) );
                if (theta[i] < minTheta){
                  minTheta = theta[i];
                }
             }
             // rotate all lines by minTheta
+            turned += minTheta;
             for (int i =0;i<4;++i){
                 para[i] = para[i].rotate( minTheta );
                 if (theta[i]==minTheta){ // if theta represents minimum, idx next point
@@ -300,7 +406,7 @@ namespace cc{
               }
             }
 
-          } while (idx[3] != loopIdx );
+          } while (turned < PI/2 );
 
           return box;
       }
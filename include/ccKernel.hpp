@@ -0,0 +1,171 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccKernel.hpp
+/// \brief Small subsets of huge point clouds with bounded hull and box error
+
+#ifndef CC_KERNEL_HEADER_INCLUDED
+#define CC_KERNEL_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2, Hull, Cancel
+
+namespace cc{
+
+  /// \brief Grid kernel of a point cloud
+  ///
+  /// The bounding box is cut into `cells` columns and `cells` rows; only the
+  /// lowest and highest point of each column and the leftmost and rightmost
+  /// of each row are kept, at most 4 * cells points, in linear time.  Every
+  /// dropped point lies between the kept extremes of its column, so within a
+  /// column width of their hull horizontally, and likewise within a row
+  /// height vertically: the kernel's hull grown by the smaller of the two
+  /// contains the cloud.  A box around the kernel grown by that distance on
+  /// each side encloses every point, which bounds the minimum box from above.
+  struct Kernel{
+
+    /// Approximate minimum box, with its guaranteed error
+    struct Estimate{
+      Hull::Box box;        ///< minimum box of the kernel
+      double area = 0;      ///< width * height of box (a lower bound)
+      double upper = 0;     ///< area of box grown by the kernel's distance (an upper bound)
+      double error = 0;     ///< relative error bound of area: (upper - area) / area
+      size_t points = 0;    ///< size of the kernel
+    };
+
+    /// Kernel of input
+    /// \param distance set to the largest distance of a dropped point from the kernel's hull
+    static std::vector<Vec2> Points( const std::vector<Vec2>& input, int cells, double& distance );
+
+    /// Minimum box of the kernel of input, and how far the true box's area can be from it
+    static Estimate Box( const std::vector<Vec2>& input, int cells, const Cancel * cancel = nullptr ){
+      Estimate e;
+      double d;
+      auto k = Points( input, cells, d );
+      e.points = k.size();
+      auto hull = Hull::Convex( k, cancel );
+      if (hull.size() < 3) return e;
+      e.box = Hull::MinimumBox( hull, cancel );
+      e.area = e.box.width * e.box.height;
+      e.upper = (e.box.width + 2*d) * (e.box.height + 2*d);
+      e.error = e.area > 0 ? (e.upper - e.area) / e.area : 0;
+      return e;
+    }
+
+    /// Bounds on the area of the minimum box of input, in linear passes without hulling:
+    /// below by the polygon of its extreme points in eight directions (inside
+    /// the hull), above by the smaller of its axis aligned and principal axes boxes
+    /// \param diameter set to the diagonal of the axis aligned box (a bound on any box side)
+    static void Bounds( const std::vector<Vec2>& input, double& lower, double& upper, double& diameter );
+
+    /// Cells needed for a relative error near epsilon on parts about as wide as they are tall
+    static int Cells( double epsilon ){
+      return std::max( 4, (int)ceil( 4.0 / std::max( epsilon, 1e-6 ) ) );
+    }
+  };
+
+    //--------------------------------------------------------------------------
+    inline void Kernel::Bounds( const std::vector<Vec2>& input, double& lower, double& upper, double& diameter ){
+
+      lower = upper = diameter = 0;
+      int n = input.size();
+      if (n < 3) return;
+
+      ///1. Extremes in eight directions, and moments
+      const double c = sqrt(.5);
+      const Vec2 dir[8] = { {1,0}, {c,c}, {0,1}, {-c,c}, {-1,0}, {-c,-c}, {0,-1}, {c,-c} };
+      int ext[8] = { 0,0,0,0,0,0,0,0 };
+      double best[8];
+      for (int k=0;k<8;++k) best[k] = Vec2::Dot( dir[k], input[0] );
+      double mx = 0, my = 0, sxx = 0, syy = 0, sxy = 0;
+      for (int i=0;i<n;++i){
+        const Vec2& p = input[i];
+        for (int k=0;k<8;++k){
+          double d = Vec2::Dot( dir[k], p );
+          if (d > best[k]) { best[k] = d; ext[k] = i; }
+        }
+        mx += p.x; my += p.y;
+      }
+      mx /= n; my /= n;
+      for (auto& p : input){
+        double dx = p.x - mx, dy = p.y - my;
+        sxx += dx*dx; syy += dy*dy; sxy += dx*dy;
+      }
+
+      ///2. Inscribed polygon of the extremes, in order of direction
+      for (int k=0;k<8;++k) lower += Vec2::Cross( input[ ext[k] ], input[ ext[(k+1)%8] ] ) / 2;
+      lower = std::max( 0.0, lower );
+
+      ///3. Axis aligned box, and the box along the principal axes
+      double w = best[0] + best[4], h = best[2] + best[6];
+      upper = w * h;
+      diameter = sqrt( w*w + h*h );
+      double a = 0.5 * atan2( 2*sxy, sxx - syy );
+      Vec2 u = { cos(a), sin(a) }, v = { -u.y, u.x };
+      double u0 = 1e300, u1 = -1e300, v0 = 1e300, v1 = -1e300;
+      for (auto& p : input){
+        double du = Vec2::Dot( u, p ), dv = Vec2::Dot( v, p );
+        u0 = std::min(u0, du); u1 = std::max(u1, du);
+        v0 = std::min(v0, dv); v1 = std::max(v1, dv);
+      }
+      upper = std::min( upper, (u1 - u0) * (v1 - v0) );
+    }
+
+    //--------------------------------------------------------------------------
+    inline std::vector<Vec2> Kernel::Points( const std::vector<Vec2>& input, int cells, double& distance ){
+
+      std::vector<Vec2> result;
+      distance = 0;
+      if (input.size() <= (size_t)(4 * cells) || cells < 1) return input;
+
+      ///1. Bounding box and cell sizes
+      double x0 = 1e300, y0 = 1e300, x1 = -1e300, y1 = -1e300;
+      for (auto& p : input){
+        x0 = std::min(x0, p.x); x1 = std::max(x1, p.x);
+        y0 = std::min(y0, p.y); y1 = std::max(y1, p.y);
+      }
+      double w = std::max( (x1 - x0) / cells, 1e-300 ), h = std::max( (y1 - y0) / cells, 1e-300 );
+      auto cell = [&]( double v, double o, double s ){
+        return std::min( cells - 1, std::max( 0, (int)( (v - o) / s ) ) );
+      };
+
+      ///2. Extremes of each column and row, by index into input
+      std::vector<int> low( cells, -1 ), high( cells, -1 ), left( cells, -1 ), right( cells, -1 );
+      for (int i=0;i<(int)input.size();++i){
+        const Vec2& p = input[i];
+        int c = cell( p.x, x0, w ), r = cell( p.y, y0, h );
+        if (low[c] < 0 || p.y < input[ low[c] ].y) low[c] = i;
+        if (high[c] < 0 || p.y > input[ high[c] ].y) high[c] = i;
+        if (left[r] < 0 || p.x < input[ left[r] ].x) left[r] = i;
+        if (right[r] < 0 || p.x > input[ right[r] ].x) right[r] = i;
+      }
+      for (auto* v : { &low, &high, &left, &right })
+        for (int i : *v) if (i >= 0) result.push_back( input[i] );
+
+      distance = std::min( x1 - x0 > 0 ? w : 0, y1 - y0 > 0 ? h : 0 );
+      return result;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_KERNEL_HEADER_INCLUDED */
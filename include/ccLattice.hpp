@@ -0,0 +1,456 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccLattice.hpp
+/// \brief Double-lattice packing of one convex part for quantity quotes
+
+#ifndef CC_LATTICE_HEADER_INCLUDED
+#define CC_LATTICE_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2
+#include "ccConstants.hpp"  //< Cost, Material
+#include "ccNfp.hpp"        //< Minkowski sums, offsets
+#include "ccData.hpp"       //< Parts
+
+namespace cc{
+
+  /// \class Lattice
+  /// \brief Dense packing of copies of a convex part and its 180 degree turn
+  ///
+  /// Copies sit at K + i*a + j*b and -K + t + i*a + j*b.  By the Kuperbergs'
+  /// theorem the densest such packing comes from the inscribed parallelogram
+  /// p, p+u, p+u+v, p+v of least area whose sides are "extensive", each at
+  /// least half the longest chord of K parallel to it (equivalently 2u and 2v
+  /// lie outside the difference body K-K): then a = 2u, b = 2v, t = 2p, and
+  /// the density is area(K) / (2 |u x v|).  A least such parallelogram has a
+  /// side exactly half the longest chord parallel to it, so the search turns u
+  /// through a half turn with |u| at half the longest chord; the two chords of
+  /// that length fix p and v, and the candidate stands if 2v is outside K-K.
+  /// Directions are sampled 16 per hull vertex (at least 512), together with
+  /// those of antipodal vertex pairs where the area kinks, and every local
+  /// minimum is narrowed by golden section.  Rows are laid along u.
+  /// Clearance is handled by offsetting the hull by half the spacing.
+  class Lattice {
+
+      std::vector<Vec2> mHull;    ///< part outline in the lattice frame, offset
+      double mArea = 0;           ///< area of the part outline
+      double mAngle = 0;          ///< turn applied to the part, in radians
+      double mHeight = 0;         ///< height of a row of K and -K+t
+      Vec2 mA, mB, mT;            ///< row period, row offset and turned copy offset
+      double mDensity = 0;        ///< fraction of the plane covered by parts
+
+      static constexpr int Directions = 16; ///< directions sampled per hull vertex, over a half turn
+      static constexpr int Refine = 40;     ///< golden section steps around each sampled minimum
+      static constexpr int Coarse = 10;     ///< of which taken around every one
+      static constexpr double Close = 1e-5; ///< relative excess of area over the best that is refined further
+      static constexpr int Fine = 8;        ///< most minima refined further
+      static constexpr double Near = 1e-2;  ///< relative excess of area over the least sample at kinks bracketed
+
+      /// Signed area of a loop
+      static double Area( const std::vector<Vec2>& p ){
+        double a = 0;
+        for (size_t i=0;i<p.size();++i) a += Vec2::Cross( p[i], p[(i+1)%p.size()] );
+        return a / 2.0;
+      }
+
+      /// Counterclockwise convex loop split into lower and upper chains by increasing x,
+      /// so vertical cuts take two binary searches
+      struct Chains{
+        std::vector<Vec2> lower, upper;
+        double x0, x1;
+
+        /// Split p, reusing storage
+        void assign( const std::vector<Vec2>& p ){
+          lower.clear(); upper.clear();
+          int n = p.size(), ll = 0, lh = 0, rl = 0, rh = 0;
+          for (int i=1;i<n;++i){
+            if (p[i].x < p[ll].x || (p[i].x == p[ll].x && p[i].y < p[ll].y)) ll = i;
+            if (p[i].x < p[lh].x || (p[i].x == p[lh].x && p[i].y > p[lh].y)) lh = i;
+            if (p[i].x > p[rl].x || (p[i].x == p[rl].x && p[i].y < p[rl].y)) rl = i;
+            if (p[i].x > p[rh].x || (p[i].x == p[rh].x && p[i].y > p[rh].y)) rh = i;
+          }
+          for (int i=ll;;i=(i+1)%n) { lower.push_back(p[i]); if (i == rl) break; }
+          for (int i=rh;;i=(i+1)%n) { upper.push_back(p[i]); if (i == lh) break; }
+          std::reverse( upper.begin(), upper.end() );
+          x0 = p[ll].x; x1 = p[rl].x;
+        }
+
+        static double At( const std::vector<Vec2>& c, double x ){
+          auto it = std::upper_bound( c.begin(), c.end(), x,
+            [](double v, const Vec2& a){ return v < a.x; } );
+          if (it == c.begin()) return c.front().y;
+          if (it == c.end()) return c.back().y;
+          const Vec2& u = *(it-1);
+          const Vec2& w = *it;
+          return u.y + (w.y - u.y) * (x - u.x) / (w.x - u.x);
+        }
+
+        /// Interval where the vertical line x cuts the loop
+        bool cut( double x, double& lo, double& hi ) const {
+          if (x < x0 || x > x1) return false;
+          lo = At( lower, x ); hi = At( upper, x );
+          return true;
+        }
+      };
+
+      /// Inscribed parallelogram p, p+u, p+u+v, p+v of K, u turned onto the vertical
+      struct Inscribed{
+        double area = 1e300;      ///< |u x v|, 1e300 if none is extensive
+        Vec2 p, u, v;
+      };
+
+      /// Chords of K parallel to one direction: K turned so they are vertical
+      struct Chords{
+        Chains chains;
+        std::vector<double> xs, length;   ///< chord length at each vertex abscissa
+        int top = 0;                      ///< index of the longest
+
+        /// Chords of a turned loop, reusing storage
+        void assign( const std::vector<Vec2>& k ){
+          chains.assign(k);
+          auto& lo = chains.lower, & hi = chains.upper;
+          // both chains run by increasing x: merge their abscissae
+          xs.clear(); length.clear(); top = 0;
+          size_t i = 0, j = 0;
+          while (i < lo.size() || j < hi.size()){
+            double x = (j == hi.size() || (i < lo.size() && lo[i].x <= hi[j].x)) ? lo[i++].x : hi[j++].x;
+            if (xs.empty() || x > xs.back()) xs.push_back(x);
+          }
+          // walk both chains along the abscissae rather than searching each
+          size_t p = 0, q = 0;
+          auto walk = []( const std::vector<Vec2>& c, size_t& k, double x ){
+            while (k + 2 < c.size() && c[k+1].x <= x) ++k;
+            const Vec2& u = c[k];
+            const Vec2& w = c[k+1];
+            if (w.x <= u.x) return u.y;
+            return u.y + (w.y - u.y) * (std::min( std::max( x, u.x ), w.x ) - u.x) / (w.x - u.x);
+          };
+          for (double x : xs){
+            double l = (hi.size() < 2 ? hi[0].y : walk( hi, q, x )) - (lo.size() < 2 ? lo[0].y : walk( lo, p, x ));
+            length.push_back( l );
+            if (l > length[top]) top = length.size() - 1;
+          }
+        }
+
+        double longest() const { return length[top]; }
+
+        /// Abscissa where the chord length falls to l, left (or right) of the longest
+        double at( double l, bool right ) const {
+          int i = top, last = xs.size() - 1, step = right ? 1 : -1;
+          // chord length is concave in x: binary search the side of the longest
+          int lo = 0, hi = right ? last - top : top;
+          while (lo < hi){
+            int m = (lo + hi + 1) / 2;
+            if (length[i + step*m] >= l) lo = m; else hi = m - 1;
+          }
+          i += step*lo;
+          if (i == (right ? last : 0)) return xs[i];
+          int j = i + step;
+          return xs[i] + (xs[j] - xs[i]) * (length[i] - l) / (length[i] - length[j]);
+        }
+      };
+
+      /// Inscribed parallelogram with vertical sides of length l, if extensive
+      /// (diff is K-K before the turn by angle that made them vertical)
+      static Inscribed Fit( const Chords& c, const std::vector<Vec2>& diff, double angle, double l );
+
+      /// Number of copies on the sheet rows of a w x h sheet, listed bottom up
+      std::vector<int> rows( double w, double h ) const;
+
+    public:
+
+      /// Densest lattice of a counterclockwise convex hull
+      /// Takes O(h^2) time in the h vertices of the hull: each of the O(h)
+      /// directions turns and cuts the whole hull, so reduce outlines of
+      /// thousands of vertices (see the tolerance below) before packing
+      Lattice( const std::vector<Vec2>& hull, double spacing = Material::Padding );
+
+      /// Densest lattice of a part's outline
+      /// (arcs circumscribed within tolerance: coarser keeps the hull small)
+      Lattice( Data& data, double spacing = Material::Padding, double tolerance = .005 )
+      : Lattice( data.outline(tolerance), spacing ) {}
+
+      /// Fraction of the plane covered by parts
+      double density() const { return mDensity; }
+
+      /// Turn applied to the part, in radians
+      double angle() const { return mAngle; }
+
+      /// Offset part outline in the lattice frame (copies are outline + i*a + j*b and t - outline + i*a + j*b)
+      const std::vector<Vec2>& outline() const { return mHull; }
+
+      /// Lattice vectors: row period a, row offset b, and offset t of the turned copies
+      Vec2 a() const { return mA; }
+      Vec2 b() const { return mB; }
+      Vec2 t() const { return mT; }
+
+      /// Copies that fit on a sheet (rows along either side)
+      int perSheet( double width, double height ) const;
+
+      /// Material cost per unit for an order
+      /// Full sheets, plus the width times the rows used on the last sheet
+      double unitMaterial( int quantity, double width, double height ) const;
+  };
+
+    //--------------------------------------------------------------------------
+    inline Lattice::Inscribed Lattice::Fit( const Chords& c, const std::vector<Vec2>& diff, double angle, double l ){
+
+      Inscribed r;
+      double x[2] = { c.at( l, false ), c.at( l, true ) };
+      if (x[1] <= x[0]) return r;
+
+      ///1. Vertical sides of length l on the two chords; a chord longer than l
+      /// (an edge along the sides) holds it at either end
+      double lo[2], hi[2];
+      for (int i=0;i<2;++i) c.chains.cut( x[i], lo[i], hi[i] );
+      double cs = cos(angle), sn = sin(angle);
+      for (double y0 : { lo[0], hi[0] - l }){
+        for (double y1 : { lo[1], hi[1] - l }){
+          Vec2 v = { x[1] - x[0], y1 - y0 };
+          ///2. Extensive: 2v outside K-K, turned back (the vertical sides are, as l is at least half the longest chord)
+          Vec2 w = { 2 * ( v.x * cs + v.y * sn ), 2 * ( v.y * cs - v.x * sn ) };
+          if (Nfp::Inside( diff, w, 1e-12 * c.longest() )) continue;
+          r.area = l * v.x;
+          r.p = { x[0], y0 };
+          r.u = { 0, l };
+          r.v = v;
+          return r;
+        }
+      }
+      return r;
+    }
+
+    //--------------------------------------------------------------------------
+    inline Lattice::Lattice( const std::vector<Vec2>& hull, double spacing ){
+
+      if (hull.size() < 3) throw std::invalid_argument("Error: Lattice Requires A Polygon.");
+      mArea = Area(hull);
+      auto K = Nfp::Offset( hull, spacing / 2.0 );
+      int n = K.size();
+      const double golden = (sqrt(5.0) - 1) / 2;
+
+      ///1. Least area extensive parallelogram with sides of half the longest chord
+      /// along the vertical, after a turn of K by angle
+      std::vector<Vec2> nK(n);
+      for (int i=0;i<n;++i) nK[i] = { -K[i].x, -K[i].y };
+      auto D = Nfp::Minkowski( K, nK );
+      std::vector<Vec2> k(n);
+      Chords chords;
+      auto search = [&]( double angle ){
+        double c = cos(angle), s = sin(angle);
+        for (int i=0;i<n;++i) k[i] = { K[i].x * c - K[i].y * s, K[i].x * s + K[i].y * c };
+        chords.assign( k );
+        if (chords.longest() <= 0) return Inscribed();
+        return Fit( chords, D, angle, chords.longest() / 2 );
+      };
+
+      ///2. Sample directions over a half turn, starting with u along the first edge,
+      /// and add those of antipodal vertex pairs, where the longest
+      /// chord changes vertices: the area kinks there, with minima narrower than a
+      /// step on either side.  Bracket each local minimum by its neighbours, and
+      /// both sides of each kink near the least
+      int samples = Directions * std::max( n, 32 );
+      double step = PI / samples, start = PI/2 - atan2( K[1].y - K[0].y, K[1].x - K[0].x );
+      std::vector<double> kinks;
+      for (int i=0, j=1; i<n; ++i){
+        Vec2 e = K[(i+1)%n] - K[i];
+        // vertex farthest across edge i, by rotating calipers
+        while (Vec2::Cross( e, K[(j+1)%n] - K[j] ) > 0) j = (j+1)%n;
+        for (int v : { i, (i+1)%n }){
+          double a = PI/2 - atan2( K[j].y - K[v].y, K[j].x - K[v].x ) - start;
+          // a pair along the first edge lands on the start, not a half turn on
+          kinks.push_back( start + a - PI * floor( a / PI + 1e-12 ) );
+        }
+      }
+      std::sort( kinks.begin(), kinks.end() );
+      // merge with the grid, a pair seen from both of its edges sampled once
+      std::vector<double> angles;
+      std::vector<bool> kink;
+      for (int i=0, j=0; i<samples || j<(int)kinks.size(); ){
+        bool k = i == samples || (j < (int)kinks.size() && kinks[j] < start + i * step);
+        double a = k ? kinks[j++] : start + (i++) * step;
+        if (!angles.empty() && a - angles.back() < 1e-12) { if (k) kink.back() = true; continue; }
+        angles.push_back( a );
+        kink.push_back( k );
+      }
+      int count = angles.size();
+      std::vector<Inscribed> sample( count );
+      double least = 1e300;
+      for (int i=0;i<count;++i) { sample[i] = search( angles[i] ); least = std::min( least, sample[i].area ); }
+      // u along the first edge wins ties, which sheets of squares and rectangles rely on
+      Inscribed best;
+      double bestAngle = 0;
+      if (sample[0].area <= least * (1 + 1e-12)) { best = sample[0]; bestAngle = angles[0]; }
+      struct Bracket{ double a, b, area; };
+      std::vector<Bracket> minima;
+      std::vector<int> sides;
+      for (int i=0;i<count;++i){
+        double area = sample[i].area;
+        double prev = i ? angles[i-1] : angles[count-1] - PI, next = i+1 < count ? angles[i+1] : angles[0] + PI;
+        if (area >= 1e300) continue;
+        if (kink[i] && area <= least * (1 + Near)) sides.push_back( i );
+        // the first sample of a level run stands for it
+        if (area >= sample[(i+count-1)%count].area || area > sample[(i+1)%count].area) continue;
+        if (area < best.area * (1 - 1e-12)) { best = sample[i]; bestAngle = angles[i]; }
+        minima.push_back( { prev, next, area } );
+      }
+      // symmetric parts tie at many kinks: the lowest few are enough
+      std::stable_sort( sides.begin(), sides.end(), [&]( int x, int y ){ return sample[x].area < sample[y].area; } );
+      for (int j=0; j<(int)sides.size() && j<Fine; ++j){
+        int i = sides[j];
+        minima.push_back( { i ? angles[i-1] : angles[count-1] - PI, angles[i], sample[i].area } );
+        minima.push_back( { angles[i], i+1 < count ? angles[i+1] : angles[0] + PI, sample[i].area } );
+      }
+
+      ///3. Narrow every bracket by golden section, first a little, then to the end
+      /// only for those close to the best
+      auto narrow = [&]( Bracket& r, int steps ){
+        for (int j=0; j<steps && r.b - r.a > 1e-12; ++j){
+          double t0 = r.b - golden * (r.b - r.a), t1 = r.a + golden * (r.b - r.a);
+          auto r0 = search( t0 ), r1 = search( t1 );
+          r.area = std::min( r.area, std::min( r0.area, r1.area ) );
+          // only a real improvement moves the best off a tie
+          if (r0.area < best.area * (1 - 1e-12)) { best = r0; bestAngle = t0; }
+          if (r1.area < best.area * (1 - 1e-12)) { best = r1; bestAngle = t1; }
+          if (r0.area <= r1.area) r.b = t1; else r.a = t0;
+        }
+      };
+      for (auto& r : minima) narrow( r, Coarse );
+      std::sort( minima.begin(), minima.end(), []( const Bracket& x, const Bracket& y ){ return x.area < y.area; } );
+      // symmetric parts tie at many minima: refining a few of them is enough
+      for (int i=0; i<(int)minima.size() && i<Fine; ++i){
+        if (minima[i].area > best.area * (1 + Close)) break;
+        narrow( minima[i], Refine - Coarse );
+      }
+      if (best.area >= 1e300) throw std::invalid_argument("Error: No Lattice Found.");
+
+      ///4. Lattice 2u, 2v and turned copies at 2p, turned back from the search
+      double c = cos(bestAngle), s = sin(bestAngle);
+      auto back = [&]( Vec2 w ){ return Vec2{ 2 * ( w.x * c + w.y * s ), 2 * ( w.y * c - w.x * s ) }; };
+      Vec2 A = back( best.u ), B = back( best.v ), T = back( best.p );
+
+      ///5. Rows along the short lattice vector whose band of K and -K+t wastes the least:
+      /// a = iA + jB with i, j coprime, and b completing the basis
+      double score = 1e300;
+      for (int j=0;j<=3;++j){
+        for (int i : { 1, 0, -1, 2, -2, 3, -3 }){
+          if (j == 0 && i != 1) continue;
+          int bi = 0, bj = 0;
+          for (int x=-3; x<=3 && !(bi || bj); ++x) for (int y=-3;y<=3;++y) if (i*y - j*x == 1) { bi = x; bj = y; break; }
+          if (!(bi || bj)) continue;
+          Vec2 a = { i*A.x + j*B.x, i*A.y + j*B.y }, b = { bi*A.x + bj*B.x, bi*A.y + bj*B.y };
+          double turn = -atan2( a.y, a.x ), tc = cos(turn), ts = sin(turn);
+          auto rotate = [&]( Vec2 w ){ return Vec2{ w.x * tc - w.y * ts, w.x * ts + w.y * tc }; };
+          std::vector<Vec2> turned(n);
+          double minY = 1e300, maxY = -1e300;
+          for (int m=0;m<n;++m){
+            turned[m] = rotate( K[m] );
+            minY = std::min( minY, turned[m].y ); maxY = std::max( maxY, turned[m].y );
+          }
+          for (auto& m : turned) m.y -= minY;
+          Vec2 t = rotate( T ), row = rotate( b );
+          t.y -= 2*minY;
+          if (row.y < 0) row = { -row.x, -row.y };
+          double H = maxY - minY, len = a.norm();
+          // turned copies in the row of K: t moved by whole rows so -K+t spans about [0,H] too
+          double rows = floor( (t.y - H) / row.y + 0.5 );
+          t = { t.x - rows * row.x, t.y - rows * row.y };
+          t.x -= len * floor( t.x / len );
+          double height = std::max( H, t.y ) - std::min( 0.0, t.y - H );
+          if (height * len >= score * (1 - 1e-9)) continue;
+          score = height * len;
+          mAngle = turn;
+          mA = { len, 0 }; mB = row; mT = t;
+          mHeight = height;
+          mHull = turned;
+        }
+      }
+      mDensity = mArea / ( 2 * best.area );
+    }
+
+    //--------------------------------------------------------------------------
+    inline std::vector<int> Lattice::rows( double w, double h ) const {
+
+      std::vector<int> result;
+      double x0 = 1e300, x1 = -1e300;
+      for (auto& v : mHull) { x0 = std::min(x0, v.x); x1 = std::max(x1, v.x); }
+      // bounds of K and of -K + t along a row
+      double kx[2][2] = { { x0, x1 }, { mT.x - x1, mT.x - x0 } };
+      double left = std::min( kx[0][0], kx[1][0] );
+
+      // spacing was split as half offsets on every copy, so the sheet edge needs none
+      for (int j=0; j*mB.y + mHeight <= h + 1e-9; ++j){
+        double o = j * mB.x;
+        o -= mA.x * floor( o / mA.x );
+        int count = 0;
+        for (auto& k : kx){
+          // copies i with left + 0 <= i*a + o + k0 - left and i*a + o + k1 - left <= w
+          double lo = ceil( (left - o - k[0]) / mA.x - 1e-9 );
+          double hi = floor( (w + left - o - k[1]) / mA.x + 1e-9 );
+          if (hi >= lo) count += (int)(hi - lo + 1);
+        }
+        result.push_back(count);
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    inline int Lattice::perSheet( double width, double height ) const {
+      int a = 0, b = 0;
+      for (int i : rows( width, height )) a += i;
+      for (int i : rows( height, width )) b += i;
+      return std::max( a, b );
+    }
+
+    //--------------------------------------------------------------------------
+    inline double Lattice::unitMaterial( int quantity, double width, double height ) const {
+
+      if (quantity <= 0) return 0;
+
+      ///1. Orientation of rows that fits the most copies
+      auto ra = rows( width, height ), rb = rows( height, width );
+      int na = 0, nb = 0;
+      for (int i : ra) na += i;
+      for (int i : rb) nb += i;
+      bool turned = nb > na;
+      auto& r = turned ? rb : ra;
+      int per = turned ? nb : na;
+      if (per == 0) throw std::invalid_argument("Error: Part Larger Than Stock.");
+      double across = turned ? height : width;
+
+      ///2. Full sheets, then rows used on the last
+      int full = quantity / per;
+      int rest = quantity - full * per;
+      double area = full * width * height;
+      for (int j=0, sum=0; rest > 0 && j<(int)r.size(); ++j){
+        sum += r[j];
+        if (sum >= rest) { area += across * ( j * mB.y + mHeight ); break; }
+      }
+      return area * Cost::PerUnitArea / quantity;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_LATTICE_HEADER_INCLUDED */
@@ -0,0 +1,130 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccMotion.hpp
+/// \brief Acceleration limited motion along a tool path
+
+#ifndef CC_MOTION_HEADER_INCLUDED
+#define CC_MOTION_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2
+
+namespace cc{
+
+  /// \class Motion
+  /// \brief Trapezoidal velocity profile over a sequence of moves
+  ///
+  /// Moves are stored as parallel arrays: length, cruise speed, and the speed
+  /// allowed at the junction where each move starts.  Junction speeds come
+  /// from the junction deviation model (the largest speed at which a circle of
+  /// radius `deviation` tangent to both moves can be followed at the given
+  /// acceleration); a pierce at the start of each loop and the end of the path
+  /// are full stops.  One backward pass limits each junction to what can be
+  /// braked from, one forward pass to what can be reached, and each move is
+  /// then timed as an accelerate, cruise, decelerate trapezoid.
+  class Motion {
+
+      double mAcceleration;
+      double mDeviation;
+
+      std::vector<double> mLength;    ///< length of each move
+      std::vector<double> mSpeed;     ///< cruise speed of each move
+      std::vector<double> mJunction;  ///< speed limit entering each move
+      Vec2 mLast;                     ///< exit direction of the last move
+      bool bStopped = true;           ///< does the next move start from rest?
+
+    public:
+
+      /// Acceleration in inches per second squared, junction deviation in inches
+      Motion( double acceleration, double deviation )
+      : mAcceleration(acceleration), mDeviation(deviation) {}
+
+      /// Largest speed through a corner between unit directions a (in) and b (out)
+      double junction( const Vec2& a, const Vec2& b ) const {
+        double c = -Vec2::Dot( a, b );                  // cosine of the angle between the moves
+        if (c > 0.999999) return 0;                     // reversal
+        double s = sqrt( 0.5 * (1.0 - c) );             // sine of half the angle
+        if (s > 0.999999) return 1e300;                 // straight on
+        return sqrt( mAcceleration * mDeviation * s / (1.0 - s) );
+      }
+
+      /// Stop before the next move (pierce of a new loop)
+      void stop() { bStopped = true; }
+
+      /// Append a move of length at cruise speed, entered along tin and left along tout
+      void add( double length, double speed, const Vec2& tin, const Vec2& tout ){
+        if (length <= 0) return;
+        double j = bStopped ? 0 : std::min( junction( mLast, tin ), std::min( speed, mSpeed.back() ) );
+        mLength.push_back( length );
+        mSpeed.push_back( speed );
+        mJunction.push_back( j );
+        mLast = tout;
+        bStopped = false;
+      }
+
+      /// Arc cruise speed: nominal speed, capped so centripetal acceleration stays in limits
+      double arc( double speed, double radius ) const {
+        return std::min( speed, sqrt( mAcceleration * radius ) );
+      }
+
+      /// Number of moves
+      size_t size() const { return mLength.size(); }
+
+      /// Time to execute all moves
+      double seconds() const;
+  };
+
+    //--------------------------------------------------------------------------
+    inline double Motion::seconds() const {
+
+      int n = mLength.size();
+      if (n == 0) return 0;
+      const double a = mAcceleration;
+      std::vector<double> v( n+1 );
+      for (int i=0;i<n;++i) v[i] = mJunction[i];
+      v[n] = 0;
+
+      ///1. Backward: every junction can brake to the next within the move between
+      for (int i=n-1;i>=0;--i) v[i] = std::min( v[i], sqrt( v[i+1]*v[i+1] + 2*a*mLength[i] ) );
+
+      ///2. Forward: every junction can be reached from the previous
+      for (int i=0;i<n;++i) v[i+1] = std::min( v[i+1], sqrt( v[i]*v[i] + 2*a*mLength[i] ) );
+
+      ///3. Trapezoid (or triangle) per move
+      double t = 0;
+      for (int i=0;i<n;++i){
+        double v0 = v[i], v1 = v[i+1], L = mLength[i], vc = mSpeed[i];
+        double up = (vc*vc - v0*v0) / (2*a), down = (vc*vc - v1*v1) / (2*a);
+        if (up + down <= L) t += (vc - v0) / a + (vc - v1) / a + (L - up - down) / vc;
+        else {
+          double vp = sqrt( (2*a*L + v0*v0 + v1*v1) / 2 );
+          t += (vp - v0) / a + (vp - v1) / a;
+        }
+      }
+      return t;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_MOTION_HEADER_INCLUDED */
@@ -0,0 +1,450 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccNest.hpp
+/// \brief Nesting many parts onto stock sheets
+
+#ifndef CC_NEST_HEADER_INCLUDED
+#define CC_NEST_HEADER_INCLUDED
+
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+#include "ccGeometry.hpp"   //< Vec2, Hull
+#include "ccConstants.hpp"  //< Profile, Material
+#include "ccData.hpp"       //< Parts
+
+#include "ccNfp.hpp"        //< No-fit polygons
+#include "ccCommonLine.hpp" //< Shared cuts
+
+namespace cc{
+
+  /// \class Nest
+  /// \brief Places the convex outlines of many parts on as few stock sheets as possible
+  ///
+  /// Each part is represented by a convex outline enclosing its geometry (arcs
+  /// circumscribed within `tolerance`) in four quarter-turn orientations.  An
+  /// order of parts is placed by bottom-left fill: on the first sheet with room,
+  /// the lowest and leftmost position and orientation that keeps `spacing`
+  /// clear of every placed part.  Positions come from the no-fit polygons of
+  /// the placed parts, cached per pair and relative rotation, so parts nest
+  /// against each other's outlines rather than their bounds.  Randomized improvement swaps
+  /// and reinserts parts in the order, keeping changes that do not use more
+  /// sheets or material; one search runs per thread until the time budget ends,
+  /// or for a fixed number of steps, when the result depends only on the seed
+  /// and the number of threads.
+  /// Material is priced from actual consumption: each sheet's width times the
+  /// height used on it (the remnant above returns to stock), at the prices of
+  /// the profile, which also times each part.  With zero spacing, straight
+  /// edges shared by neighbouring parts are cut once, and the best nesting's
+  /// machine time is reduced by the shared length at the profile's velocity.
+  class Nest {
+
+    public:
+
+      /// Stock sheet size
+      struct Sheet{
+        double width, height;
+      };
+
+      /// Where a part was placed
+      struct Placement{
+        int part;           ///< index of part in order of add()
+        int sheet;          ///< index of sheet in Result
+        int rotation;       ///< quarter turns counterclockwise
+        Vec2 position;      ///< offset of the rotated outline's lower left bound
+      };
+
+      /// A complete nesting
+      struct Result{
+        std::vector<Placement> placement;   ///< one per part
+        std::vector<int> stock;             ///< stock size index of each sheet
+        std::vector<double> used;           ///< height used on each sheet
+        double area = 0;                    ///< material consumed
+        double seconds = 0;                 ///< machine time of all parts
+        double common = 0;                  ///< straight cut length shared by neighbouring parts (0 unless spacing is 0)
+        double cost = 0;                    ///< cost in dollars
+
+        /// Number of sheets used
+        int sheets() const { return stock.size(); }
+
+        /// Fewer sheets first, then less material
+        bool operator < (const Result& b) const {
+          return sheets() < b.sheets() || (sheets() == b.sheets() && area < b.area);
+        }
+      };
+
+      /// A part outline in one orientation, with its lower left bound at the origin
+      struct Outline{
+        std::vector<Vec2> points;   ///< counterclockwise convex loop
+        double width, height;       ///< bounds
+        Vec2 shift;                 ///< lower left bound of the turned loop, subtracted from points
+      };
+
+    private:
+
+      /// A part in four orientations
+      struct Part{
+        uint64_t hash;              ///< geometry and tolerance
+        std::vector<Vec2> hull;     ///< unturned outline
+        std::vector< std::pair<Vec2,Vec2> > lines;   ///< unturned straight edges
+        Outline outline[4];
+        double seconds;
+        double area;
+      };
+
+      /// A placed part
+      struct Placed{
+        int part;
+        int rotation;
+        Vec2 position;
+      };
+
+      std::vector<Part> mPart;
+      std::vector<Sheet> mStock;
+      double mSpacing = Material::Padding;
+      double mTolerance = .005;
+      Profile mProfile;
+      std::chrono::milliseconds mBudget{200};
+      int mThreads = 0;
+      int mSteps = 0;
+      unsigned mSeed = 0;
+
+      /// No-fit polygons shared by all searches
+      mutable NfpCache mNfp;
+
+      /// Place parts in order by bottom-left fill
+      Result place( const std::vector<int>& order ) const;
+
+      /// Find the bottom-left position of a part in one orientation on a sheet
+      /// \returns false if it does not fit
+      bool fit( int part, int rotation, const Sheet& s, const std::vector<Placed>& placed, Vec2& pos ) const;
+
+      /// Subtract straight cuts shared by neighbouring parts from a nesting's time
+      void share( Result& r ) const;
+
+      /// Search from an initial order (shuffled if asked) for mSteps steps, or until deadline
+      Result search( std::vector<int> order, unsigned seed, bool shuffle, Cancel::Clock::time_point deadline ) const;
+
+    public:
+
+      /// Rotate a counterclockwise loop by quarter turns and move its lower left bound to the origin
+      static Outline Orient( const std::vector<Vec2>& loop, int quarterTurns );
+
+      /// Add copies of a part (call tolerance() and profile() first to change them)
+      void add( Data& data, int quantity = 1 );
+
+      /// Set maximum distance from arcs to part outlines
+      void tolerance( double t ) { mTolerance = t; }
+
+      /// Set velocities and prices that parts are timed and nestings priced at
+      void profile( const Profile& f ) { mProfile = f; }
+
+      /// Add an available stock sheet size (new sheets use the first size that fits)
+      void stock( double width, double height ) { mStock.push_back( {width, height} ); }
+
+      /// Set minimum clearance between parts (default Material::Padding; only 0 lets parts share cuts)
+      void spacing( double s ) { mSpacing = s; }
+
+      /// Set time budget of the improvement search
+      void budget( std::chrono::milliseconds ms ) { mBudget = ms; }
+
+      /// Set number of search threads (0 uses all cores)
+      void threads( int n ) { mThreads = n; }
+
+      /// Set a fixed number of improvement steps per thread in place of the budget (0 uses the budget)
+      void steps( int n ) { mSteps = n; }
+
+      /// Set seed of the searches (thread t uses seed + t)
+      void seed( unsigned s ) { mSeed = s; }
+
+      /// Number of parts added
+      size_t size() const { return mPart.size(); }
+
+      /// Number of distinct no-fit polygons computed so far
+      size_t nfps() const { return mNfp.size(); }
+
+      /// Oriented outline of a part (for drawing placements)
+      const Outline& outline( int part, int rotation ) const { return mPart[part].outline[rotation & 3]; }
+
+      /// Nest all parts on stock sheets
+      /// \returns best nesting found within the budget
+      Result run() const;
+  };
+
+    //--------------------------------------------------------------------------
+    inline Nest::Outline Nest::Orient( const std::vector<Vec2>& loop, int quarterTurns ){
+      Outline o;
+      o.points.reserve( loop.size() );
+      for (auto& i : loop) o.points.push_back( Nfp::Turn( i, quarterTurns ) );
+      double minX = 0, minY = 0, maxX = 0, maxY = 0;
+      if (!o.points.empty()){
+        minX = maxX = o.points[0].x;
+        minY = maxY = o.points[0].y;
+      }
+      for (auto& v : o.points){
+        minX = std::min(minX, v.x); maxX = std::max(maxX, v.x);
+        minY = std::min(minY, v.y); maxY = std::max(maxY, v.y);
+      }
+      o.shift = {minX, minY};
+      for (auto& v : o.points) v = v - o.shift;
+      o.width = maxX - minX;
+      o.height = maxY - minY;
+      return o;
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Nest::add( Data& data, int quantity ){
+      Part p;
+      p.hash = Hash::Combine( data.hash(), Hash::Of(mTolerance) );
+      p.hull = data.outline( mTolerance );
+      p.lines = data.lines();
+      for (int r=0;r<4;++r) p.outline[r] = Orient( p.hull, r );
+      p.seconds = data.seconds( mProfile );
+      p.area = p.outline[0].width * p.outline[0].height;
+      for (int i=0;i<quantity;++i) mPart.push_back(p);
+    }
+
+    //--------------------------------------------------------------------------
+    inline bool Nest::fit( int part, int rotation, const Sheet& s, const std::vector<Placed>& placed, Vec2& pos ) const {
+
+      const Part& b = mPart[part];
+      const Outline& o = b.outline[rotation];
+      double maxX = s.width - o.width, maxY = s.height - o.height;
+      if (maxX < 0 || maxY < 0) return false;
+
+      ///1. Forbidden region of this outline's position around each placed part:
+      /// the cached no-fit polygon, turned by the placed part's rotation and moved to it
+      struct Region{
+        std::vector<Vec2> poly;
+        double minX, minY, maxX, maxY;
+      };
+      std::vector<Region> regions( placed.size() );
+      for (size_t i=0;i<placed.size();++i){
+        const Part& a = mPart[ placed[i].part ];
+        int ra = placed[i].rotation;
+        auto nfp = mNfp.get( a.hash, a.hull, b.hash, b.hull, rotation - ra );
+        Vec2 t = placed[i].position - a.outline[ra].shift + o.shift;
+        auto& r = regions[i];
+        r.poly.resize( nfp->size() );
+        r.minX = r.minY = 1e300; r.maxX = r.maxY = -1e300;
+        for (size_t k=0;k<nfp->size();++k){
+          Vec2 v = Nfp::Turn( (*nfp)[k], ra ) + t;
+          r.poly[k] = v;
+          r.minX = std::min(r.minX, v.x); r.maxX = std::max(r.maxX, v.x);
+          r.minY = std::min(r.minY, v.y); r.maxY = std::max(r.maxY, v.y);
+        }
+      }
+
+      ///2. Candidates: sheet corner, region vertices, region edges meeting the
+      /// sheet edges, and crossings of overlapping regions (touching two parts)
+      std::vector<Vec2> candidates( 1, Vec2{0,0} );
+      for (size_t i=0;i<regions.size();++i){
+        auto& r = regions[i];
+        int n = r.poly.size();
+        for (int k=0;k<n;++k){
+          const Vec2& p = r.poly[k];
+          const Vec2& q = r.poly[(k+1)%n];
+          candidates.push_back(p);
+          if ((p.y < 0) != (q.y < 0)) candidates.push_back( { p.x + (q.x-p.x) * (0-p.y)/(q.y-p.y), 0 } );
+          if ((p.x < 0) != (q.x < 0)) candidates.push_back( { 0, p.y + (q.y-p.y) * (0-p.x)/(q.x-p.x) } );
+        }
+        for (size_t j=i+1;j<regions.size();++j){
+          auto& w = regions[j];
+          if (w.minX > r.maxX || r.minX > w.maxX || w.minY > r.maxY || r.minY > w.maxY) continue;
+          int m = w.poly.size();
+          for (int k=0;k<n;++k){
+            const Vec2& p = r.poly[k];
+            Vec2 e = r.poly[(k+1)%n] - p;
+            for (int l=0;l<m;++l){
+              const Vec2& q = w.poly[l];
+              Vec2 f = w.poly[(l+1)%m] - q;
+              double d = Vec2::Cross(e, f);
+              if (d == 0) continue;
+              double t = Vec2::Cross(q - p, f) / d;
+              double u = Vec2::Cross(q - p, e) / d;
+              if (t >= 0 && t <= 1 && u >= 0 && u <= 1) candidates.push_back( { p.x + e.x*t, p.y + e.y*t } );
+            }
+          }
+        }
+      }
+      std::sort( candidates.begin(), candidates.end(), [](const Vec2& a, const Vec2& b){
+        return a.y < b.y || (a.y == b.y && a.x < b.x);
+      });
+
+      ///3. Lowest, then leftmost, candidate on the sheet and outside every region
+      const double eps = 1e-9;
+      for (auto& c : candidates){
+        if (c.x < -eps || c.y < -eps || c.x > maxX + eps || c.y > maxY + eps) continue;
+        bool clear = true;
+        for (auto& r : regions){
+          if (c.x <= r.minX || c.x >= r.maxX || c.y <= r.minY || c.y >= r.maxY) continue;
+          if (Nfp::Inside( r.poly, c )) { clear = false; break; }
+        }
+        if (clear){
+          pos = { std::min( std::max(c.x, 0.0), maxX ), std::min( std::max(c.y, 0.0), maxY ) };
+          return true;
+        }
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    inline Nest::Result Nest::place( const std::vector<int>& order ) const {
+
+      Result result;
+      result.placement.resize( mPart.size() );
+      std::vector< std::vector<Placed> > sheets;
+
+      for (int idx : order){
+        auto& part = mPart[idx];
+        bool done = false;
+
+        ///1. First sheet with room, best orientation on it
+        for (int s=0; s<(int)sheets.size() && !done; ++s){
+          const Sheet& stock = mStock[ result.stock[s] ];
+          Vec2 best; int rot = -1;
+          for (int r=0;r<4;++r){
+            Vec2 pos;
+            if ( fit( idx, r, stock, sheets[s], pos ) &&
+                 ( rot < 0 || pos.y < best.y || (pos.y == best.y && pos.x < best.x) ) ){
+              best = pos; rot = r;
+            }
+          }
+          if (rot >= 0){
+            sheets[s].push_back( { idx, rot, best } );
+            result.placement[idx] = { idx, s, rot, best };
+            result.used[s] = std::max( result.used[s], best.y + part.outline[rot].height );
+            done = true;
+          }
+        }
+
+        ///2. Otherwise open a sheet of the first stock size that fits
+        for (int k=0; k<(int)mStock.size() && !done; ++k){
+          for (int r=0;r<4 && !done;++r){
+            auto& o = part.outline[r];
+            if (o.width <= mStock[k].width && o.height <= mStock[k].height){
+              sheets.push_back( std::vector<Placed>( 1, Placed{ idx, r, {0,0} } ) );
+              result.stock.push_back(k);
+              result.used.push_back( o.height );
+              result.placement[idx] = { idx, (int)sheets.size()-1, r, {0,0} };
+              done = true;
+            }
+          }
+        }
+        if (!done) throw std::invalid_argument("Error: Part Larger Than Stock.");
+      }
+
+      ///3. Price consumption
+      for (int s=0;s<result.sheets();++s) result.area += mStock[ result.stock[s] ].width * result.used[s];
+      for (auto& i : mPart) result.seconds += i.seconds;
+      result.cost = result.seconds * mProfile.perSecond + result.area * mProfile.perUnitArea;
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Nest::share( Result& r ) const {
+      std::vector<CommonLine> sheets( r.sheets() );
+      for (auto& p : r.placement){
+        auto& part = mPart[ p.part ];
+        Vec2 t = p.position - part.outline[p.rotation].shift;
+        for (auto& l : part.lines){
+          sheets[ p.sheet ].add( Nfp::Turn( l.first, p.rotation ) + t, Nfp::Turn( l.second, p.rotation ) + t, p.part );
+        }
+      }
+      r.common = 0;
+      for (auto& s : sheets) r.common += s.shared();
+      r.seconds -= r.common / mProfile.velocity;
+      r.cost = r.seconds * mProfile.perSecond + r.area * mProfile.perUnitArea;
+    }
+
+    //--------------------------------------------------------------------------
+    inline Nest::Result Nest::search( std::vector<int> order, unsigned seed, bool shuffle, Cancel::Clock::time_point deadline ) const {
+
+      std::mt19937 rng(seed);
+      if (shuffle) std::shuffle( order.begin(), order.end(), rng );
+      Result best = place(order);
+      int n = order.size();
+      if (n < 2) return best;
+
+      std::uniform_int_distribution<int> pick(0, n-1);
+      int step = 0;
+      do {
+        auto next = order;
+        int a = pick(rng), b = pick(rng);
+        if (rng() & 1) std::swap( next[a], next[b] );
+        else {
+          // reinsert one part elsewhere in the order
+          int v = next[a];
+          next.erase( next.begin() + a );
+          next.insert( next.begin() + b, v );
+        }
+        Result r = place(next);
+        if ( !(best < r) ){
+          best = r;
+          order = next;
+        }
+      } while ( mSteps > 0 ? ++step < mSteps : Cancel::Clock::now() < deadline );
+      return best;
+    }
+
+    //--------------------------------------------------------------------------
+    inline Nest::Result Nest::run() const {
+
+      if (mStock.empty()) throw std::invalid_argument("Error: No Stock Sheets.");
+      if (mPart.empty()) return Result();
+      for (auto& i : mPart){
+        bool fits = false;
+        for (auto& k : mStock) for (auto& o : i.outline) fits |= o.width <= k.width && o.height <= k.height;
+        if (!fits) throw std::invalid_argument("Error: Part Larger Than Stock.");
+      }
+
+      mNfp.spacing( mSpacing );
+
+      ///1. Start from parts in order of decreasing bounds area
+      std::vector<int> order( mPart.size() );
+      for (size_t i=0;i<order.size();++i) order[i] = i;
+      std::stable_sort( order.begin(), order.end(),
+        [this](int a, int b){ return mPart[a].area > mPart[b].area; } );
+
+      ///2. Independent searches on each thread; the first keeps the sorted start
+      int n = mThreads > 0 ? mThreads : std::max( 1u, std::thread::hardware_concurrency() );
+      auto deadline = Cancel::Clock::now() + mBudget;
+      std::vector<Result> results(n);
+      std::vector<std::thread> workers;
+      for (int t=1;t<n;++t){
+        workers.push_back( std::thread( [&, t]{ results[t] = search( order, mSeed + t, true, deadline ); } ) );
+      }
+      results[0] = search( order, mSeed, false, deadline );
+      for (auto& i : workers) i.join();
+
+      ///3. Price shared cuts of the best nesting only
+      Result best = *std::min_element( results.begin(), results.end() );
+      share( best );
+      return best;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_NEST_HEADER_INCLUDED */
@@ -0,0 +1,184 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccNfp.hpp
+/// \brief No-fit polygons of convex outlines, and a cache of them for nesting
+
+#ifndef CC_NFP_HEADER_INCLUDED
+#define CC_NFP_HEADER_INCLUDED
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+
+#include "ccGeometry.hpp"   //< Vec2, Hash
+
+namespace cc{
+
+  /// \brief No-fit polygon operations on counterclockwise convex loops
+  ///
+  /// The no-fit polygon of A and B is the set of translations p of B at which
+  /// B+p overlaps A: for convex loops it is the Minkowski sum A + (-B), built in
+  /// O(n+m) by merging the two edge sequences by angle.  Arcs are handled by
+  /// the caller supplying outlines that circumscribe them within a tolerance
+  /// (see Data::outline), so the result never under-reports overlap.
+  struct Nfp{
+
+    /// Rotate a point by quarter turns counterclockwise (exact)
+    static Vec2 Turn( Vec2 v, int quarterTurns ){
+      for (int r=0;r<(quarterTurns & 3);++r) v = { -v.y, v.x };
+      return v;
+    }
+
+    /// Minkowski sum of two counterclockwise convex loops
+    static std::vector<Vec2> Minkowski( const std::vector<Vec2>& a, const std::vector<Vec2>& b ){
+
+      std::vector<Vec2> result;
+      int n = a.size(), m = b.size();
+      if (n == 0 || m == 0) return result;
+
+      ///1. Start from the lowest (then leftmost) vertex of each
+      auto lowest = []( const std::vector<Vec2>& p ){
+        int k = 0;
+        for (int i=1;i<(int)p.size();++i){
+          if (p[i].y < p[k].y || (p[i].y == p[k].y && p[i].x < p[k].x)) k = i;
+        }
+        return k;
+      };
+      int i0 = lowest(a), j0 = lowest(b);
+
+      ///2. Merge edges in order of angle
+      int i = 0, j = 0;
+      result.reserve( n + m );
+      while (i < n || j < m){
+        result.push_back( a[(i0+i)%n] + b[(j0+j)%m] );
+        Vec2 ea = a[(i0+i+1)%n] - a[(i0+i)%n];
+        Vec2 eb = b[(j0+j+1)%m] - b[(j0+j)%m];
+        double c = Vec2::Cross( ea, eb );
+        if (j == m || (i < n && c > 0)) ++i;
+        else if (i == n || c < 0) ++j;
+        else { ++i; ++j; }
+      }
+      return result;
+    }
+
+    /// No-fit polygon of a and b, with b turned by quarter turns
+    static std::vector<Vec2> Compute( const std::vector<Vec2>& a, const std::vector<Vec2>& b, int quarterTurns ){
+      std::vector<Vec2> nb( b.size() );
+      for (size_t i=0;i<b.size();++i){
+        Vec2 t = Turn( b[i], quarterTurns );
+        nb[i] = { -t.x, -t.y };
+      }
+      return Minkowski( a, nb );
+    }
+
+    /// Move every edge of a counterclockwise convex loop outward by d (sharp corners)
+    static std::vector<Vec2> Offset( const std::vector<Vec2>& p, double d ){
+      int n = p.size();
+      if (d == 0 || n < 3) return p;
+      std::vector<Vec2> result(n);
+      for (int i=0;i<n;++i){
+        // corner between edge into p[i] and edge out of p[i]
+        Vec2 e0 = (p[i] - p[(i+n-1)%n]).unit();
+        Vec2 e1 = (p[(i+1)%n] - p[i]).unit();
+        Vec2 n0 = { e0.y, -e0.x }, n1 = { e1.y, -e1.x };
+        Vec2 bisect = n0 + n1;
+        double k = 1.0 + Vec2::Dot(n0, n1);
+        result[i] = (k > 1e-12) ? p[i] + Vec2{ bisect.x * d / k, bisect.y * d / k }
+                                : p[i] + Vec2{ n1.x * d, n1.y * d };
+      }
+      return result;
+    }
+
+    /// Is point strictly inside a counterclockwise convex loop?
+    static bool Inside( const std::vector<Vec2>& p, const Vec2& v, double eps = 1e-9 ){
+      int n = p.size();
+      if (n < 3) return false;
+      for (int i=0;i<n;++i){
+        Vec2 e = p[(i+1)%n] - p[i];
+        if ( Vec2::Cross( e, v - p[i] ) <= eps * e.norm() ) return false;
+      }
+      return true;
+    }
+  };
+
+  /// \class NfpCache
+  /// \brief Thread-safe cache of no-fit polygons by (part hash, part hash, relative rotation)
+  ///
+  /// Polygons are stored in the unrotated frames of the two parts, already
+  /// offset by the clearance (which is part of the key, read once per lookup),
+  /// so every pair and relative quarter turn in an order is computed once;
+  /// callers turn and translate the result.  Outlines must be convex: a
+  /// concave part is given by its convex hull (as Nest gives it), which never
+  /// under-reports overlap but leaves its concavities unused.
+  class NfpCache {
+
+      double mSpacing = 0;
+      std::mutex mMutex;
+      std::unordered_map< uint64_t, std::shared_ptr< const std::vector<Vec2> > > mNfp;
+
+    public:
+
+      typedef std::shared_ptr< const std::vector<Vec2> > Polygon;
+
+      /// Set clearance between parts (clears the cache if changed)
+      void spacing( double s ){
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (s != mSpacing) mNfp.clear();
+        mSpacing = s;
+      }
+
+      /// No-fit polygon of b (turned by quarter turns) around a, offset by the clearance
+      Polygon get( uint64_t ha, const std::vector<Vec2>& a,
+                   uint64_t hb, const std::vector<Vec2>& b, int quarterTurns ){
+        uint64_t key;
+        double spacing;
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+          spacing = mSpacing;
+          key = Hash::Combine( Hash::Combine( Hash::Combine(ha, hb), quarterTurns & 3 ), Hash::Of(spacing) );
+          auto it = mNfp.find(key);
+          if (it != mNfp.end()) return it->second;
+        }
+        // compute outside the lock; a concurrent duplicate is harmless, and a
+        // polygon computed across a change of spacing is keyed by the old one
+        Polygon p = std::make_shared< const std::vector<Vec2> >(
+          Nfp::Offset( Nfp::Compute( a, b, quarterTurns ), spacing ) );
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mNfp.emplace( key, p ).first->second;
+      }
+
+      /// Number of cached polygons
+      size_t size() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mNfp.size();
+      }
+
+      /// Remove all cached polygons
+      void clear() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mNfp.clear();
+      }
+  };
+
+} //cc::
+
+#endif /* end of include guard: CC_NFP_HEADER_INCLUDED */
@@ -0,0 +1,228 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccOffset.hpp
+/// \brief Offsetting closed loops of lines and arcs, for kerf compensation
+
+#ifndef CC_OFFSET_HEADER_INCLUDED
+#define CC_OFFSET_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2
+#include "ccMacros.hpp"     //< PI
+
+namespace cc{
+
+  /// A straight or circular piece of a path, in order of travel
+  struct Piece{
+    Vec2 a, b;            ///< start and end
+    Vec2 center;          ///< center of an arc
+    double sweep = 0;     ///< signed radians of an arc (counterclockwise positive), 0 if straight
+    bool bJoin = false;   ///< inserted by an offset to turn a corner
+
+    bool arc() const { return sweep != 0; }
+
+    double radius() const { return (a - center).norm(); }
+
+    double length() const { return arc() ? radius() * fabs(sweep) : (b - a).norm(); }
+
+    /// Unit tangent at a point of the piece, in the direction of travel
+    Vec2 tangent( const Vec2& p ) const {
+      if (!arc()) return (b - a).unit();
+      Vec2 r = p - center;
+      return sweep > 0 ? Vec2{ -r.y, r.x }.unit() : Vec2{ r.y, -r.x }.unit();
+    }
+
+    /// Same piece travelled from b to a
+    Piece reversed() const {
+      Piece p = *this;
+      std::swap( p.a, p.b );
+      p.sweep = -sweep;
+      return p;
+    }
+
+    /// Signed area swept from the origin (sums to the enclosed area of a loop)
+    double area() const {
+      double s = Vec2::Cross( a, b ) / 2.0;
+      if (arc()){
+        double r = radius();
+        s += r * r * ( sweep - sin(sweep) ) / 2.0;
+      }
+      return s;
+    }
+  };
+
+  /// \brief Offset of a closed loop of pieces
+  ///
+  /// Lines move along their normals and arcs change radius about the same
+  /// center, so arcs stay arcs.  Where offset pieces part at a convex corner
+  /// they are joined by an arc about the corner, which is the path a round
+  /// tool takes; where they cross at a concave corner both are trimmed at the
+  /// crossing nearest the corner.  Arcs whose radius would vanish are dropped.
+  /// Each piece is visited once; features narrower than the offset are not
+  /// removed (the result may then loop over itself).
+  struct Offset{
+
+    /// Signed enclosed area of a closed loop (counterclockwise positive)
+    static double Area( const std::vector<Piece>& loop ){
+      double s = 0;
+      for (auto& p : loop) s += p.area();
+      return s;
+    }
+
+    /// Offset a closed loop away from the region it encloses by d (inward if d < 0)
+    static std::vector<Piece> Loop( const std::vector<Piece>& loop, double d );
+
+    /// Signed angle from u to w
+    static double Angle( const Vec2& u, const Vec2& w ){
+      return atan2( Vec2::Cross(u, w), Vec2::Dot(u, w) );
+    }
+
+    /// Crossing of two pieces' lines or circles nearest a point
+    /// \returns false if they do not meet
+    static bool Cross( const Piece& p, const Piece& q, const Vec2& near, Vec2& x );
+  };
+
+    //--------------------------------------------------------------------------
+    inline bool Offset::Cross( const Piece& p, const Piece& q, const Vec2& near, Vec2& x ){
+
+      std::vector<Vec2> hits;
+
+      // a line through o along u against a circle of radius r about c
+      auto lineCircle = [&]( const Vec2& o, const Vec2& u, const Vec2& c, double r ){
+        Vec2 f = o - c;
+        double b = Vec2::Dot(f, u), k = Vec2::Dot(f, f) - r*r;
+        double disc = b*b - k;
+        if (disc < 0) return;
+        double s = sqrt(disc);
+        hits.push_back( o + Vec2{ u.x * (-b-s), u.y * (-b-s) } );
+        hits.push_back( o + Vec2{ u.x * (-b+s), u.y * (-b+s) } );
+      };
+
+      if (!p.arc() && !q.arc()){
+        Vec2 e = p.b - p.a, f = q.b - q.a;
+        double den = Vec2::Cross(e, f);
+        if (fabs(den) < 1e-15) return false;
+        double t = Vec2::Cross(q.a - p.a, f) / den;
+        hits.push_back( p.a + Vec2{ e.x * t, e.y * t } );
+      } else if (!p.arc() || !q.arc()){
+        const Piece& l = p.arc() ? q : p;
+        const Piece& c = p.arc() ? p : q;
+        lineCircle( l.a, (l.b - l.a).unit(), c.center, c.radius() );
+      } else {
+        Vec2 c0 = p.center, c1 = q.center;
+        double r0 = p.radius(), r1 = q.radius();
+        Vec2 dc = c1 - c0;
+        double L = dc.norm();
+        if (L < 1e-15 || L > r0 + r1 || L < fabs(r0 - r1)) return false;
+        double m = (r0*r0 - r1*r1 + L*L) / (2*L);
+        double h = sqrt( std::max( 0.0, r0*r0 - m*m ) );
+        Vec2 u = dc.unit();
+        Vec2 mid = c0 + Vec2{ u.x * m, u.y * m };
+        hits.push_back( mid + Vec2{ -u.y * h, u.x * h } );
+        hits.push_back( mid + Vec2{ u.y * h, -u.x * h } );
+      }
+      if (hits.empty()) return false;
+      x = hits[0];
+      for (auto& h : hits) if ((h - near).norm() < (x - near).norm()) x = h;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    inline std::vector<Piece> Offset::Loop( const std::vector<Piece>& loop, double d ){
+
+      int n = loop.size();
+      if (n == 0 || d == 0) return loop;
+
+      ///1. Outward is right of travel on a counterclockwise loop, left on a clockwise one
+      double e = Area(loop) >= 0 ? d : -d;
+
+      ///2. Move every piece: lines along the right normal, arcs by radius
+      std::vector<Piece> moved;
+      std::vector<Vec2> corner;   // original vertex at the end of each moved piece
+      moved.reserve(n);
+      for (auto& p : loop){
+        Piece q = p;
+        if (!p.arc()){
+          Vec2 t = (p.b - p.a).unit();
+          Vec2 s = { t.y * e, -t.x * e };
+          q.a = p.a + s; q.b = p.b + s;
+        } else {
+          double r = p.radius();
+          double r2 = r + (p.sweep > 0 ? e : -e);
+          if (r2 <= 1e-12) continue;
+          Vec2 ua = (p.a - p.center).unit(), ub = (p.b - p.center).unit();
+          q.a = p.center + Vec2{ ua.x * r2, ua.y * r2 };
+          q.b = p.center + Vec2{ ub.x * r2, ub.y * r2 };
+        }
+        moved.push_back(q);
+        corner.push_back(p.b);
+      }
+
+      ///3. Trim consecutive pieces where they cross at concave corners
+      int m = moved.size();
+      std::vector<bool> changed( m, false );
+      for (int i=0; i<m && m>1; ++i){
+        Piece& p = moved[i];
+        Piece& q = moved[(i+1)%m];
+        if ((p.b - q.a).norm() < 1e-12) continue;
+        double turn = Vec2::Cross( p.tangent(p.b), q.tangent(q.a) );
+        Vec2 x;
+        if (turn * e > 0 || !Cross( p, q, corner[i], x )) continue;
+        p.b = q.a = x;
+        changed[i] = changed[(i+1)%m] = true;
+      }
+      // trimmed arcs sweep between their new ends, by the turn nearest the
+      // old sweep: in its direction, further where a crossing is on the arc's
+      // extension, and back (as a line would) where the trims pass each other
+      for (int i=0;i<m;++i){
+        Piece& p = moved[i];
+        if (!changed[i] || !p.arc()) continue;
+        double s = Angle( p.a - p.center, p.b - p.center );
+        p.sweep = s + 2*PI * round( (p.sweep - s) / (2*PI) );
+      }
+
+      ///4. Join what remains apart: an arc about the corner, or a straight link
+      std::vector<Piece> result;
+      result.reserve( 2*m );
+      for (int i=0;i<m;++i){
+        const Piece& p = moved[i];
+        const Piece& q = moved[(i+1)%m];
+        result.push_back(p);
+        if ((p.b - q.a).norm() < 1e-12) continue;
+        const Vec2& v = corner[i];
+        Piece join;
+        join.a = p.b; join.b = q.a;
+        join.bJoin = true;
+        if ( fabs( (p.b - v).norm() - fabs(e) ) < 1e-9 && fabs( (q.a - v).norm() - fabs(e) ) < 1e-9 ){
+          join.center = v;
+          join.sweep = Angle( p.b - v, q.a - v );
+        }
+        result.push_back(join);
+      }
+      return result;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_OFFSET_HEADER_INCLUDED */
@@ -0,0 +1,210 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccPack.hpp
+/// \brief Fast skyline packing of minimum boxes onto stock sheets
+
+#ifndef CC_PACK_HEADER_INCLUDED
+#define CC_PACK_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "ccGeometry.hpp"   //< Vec2, Hull::Box
+#include "ccConstants.hpp"  //< Material
+#include "ccData.hpp"       //< Parts
+
+namespace cc{
+
+  /// \class Pack
+  /// \brief First-tier order quoting: packs each part's minimum box rather than its outline
+  ///
+  /// Rectangles are sorted by decreasing longer side and placed with the
+  /// skyline bottom-left rule (lowest top, then leftmost), trying both
+  /// orientations.  Only the most recently opened sheets are searched, so the
+  /// time grows with the number of rectangles and the length of the open
+  /// skylines, not with the sheets already filled (test/pack.cpp prints it for
+  /// tens of thousands).  Clearance is handled by growing every rectangle and
+  /// the sheet by `spacing`.
+  class Pack {
+
+    public:
+
+      /// Rectangle to pack
+      struct Rect{
+        double width, height;
+      };
+
+      /// Where a rectangle was placed
+      struct Placement{
+        int sheet;          ///< index of sheet
+        bool bRotated;      ///< width and height swapped
+        Vec2 position;      ///< lower left corner
+      };
+
+      /// A complete packing
+      struct Result{
+        std::vector<Placement> placement;   ///< one per rectangle, in order of add()
+        int sheets = 0;                     ///< sheets used
+        double area = 0;                    ///< total area of rectangles
+        double utilization = 0;             ///< area / (sheets * sheet area)
+      };
+
+    private:
+
+      /// Horizontal segment of a skyline
+      struct Segment{
+        double x, y, width;
+      };
+
+      std::vector<Rect> mRect;
+      Rect mSheet = {0,0};
+      double mSpacing = Material::Padding;
+      int mOpen = 4;
+
+      /// Best position of a w x h rectangle on a skyline
+      /// \returns index of the first segment covered, or -1
+      static int Find( const std::vector<Segment>& sky, double w, double h, double H, double& x, double& y );
+
+      /// Raise a skyline under a placed rectangle
+      static void Raise( std::vector<Segment>& sky, int i, double w, double top );
+
+    public:
+
+      /// Add copies of a rectangle
+      void add( double width, double height, int quantity = 1 ){
+        for (int i=0;i<quantity;++i) mRect.push_back( {width, height} );
+      }
+
+      /// Add copies of a part's minimum box
+      void add( Data& data, int quantity = 1 ){
+        auto box = data.box();
+        add( box.width, box.height, quantity );
+      }
+
+      /// Set stock sheet size
+      void stock( double width, double height ) { mSheet = {width, height}; }
+
+      /// Set minimum clearance between rectangles (default Material::Padding)
+      void spacing( double s ) { mSpacing = s; }
+
+      /// Set how many of the latest sheets stay open for placement
+      void open( int n ) { mOpen = n > 0 ? n : 1; }
+
+      /// Number of rectangles added
+      size_t size() const { return mRect.size(); }
+
+      /// Pack all rectangles
+      Result run() const;
+  };
+
+    //--------------------------------------------------------------------------
+    inline int Pack::Find( const std::vector<Segment>& sky, double w, double h, double H, double& x, double& y ){
+      int best = -1;
+      double right = sky.back().x + sky.back().width;
+      for (int i=0;i<(int)sky.size();++i){
+        double left = sky[i].x;
+        if (left + w > right + 1e-9) break;
+        // rest on the highest segment under [left, left+w)
+        double top = 0;
+        for (int j=i; j<(int)sky.size() && sky[j].x < left + w - 1e-9; ++j) top = std::max( top, sky[j].y );
+        if (top + h > H + 1e-9) continue;
+        if (best < 0 || top < y || (top == y && left < x)){
+          best = i; x = left; y = top;
+        }
+      }
+      return best;
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Pack::Raise( std::vector<Segment>& sky, int i, double w, double top ){
+      double left = sky[i].x, end = left + w;
+      // drop or trim segments under the new one
+      int j = i;
+      while (j < (int)sky.size() && sky[j].x + sky[j].width <= end + 1e-9) ++j;
+      if (j < (int)sky.size() && sky[j].x < end){
+        sky[j].width -= end - sky[j].x;
+        sky[j].x = end;
+      }
+      sky.erase( sky.begin() + i, sky.begin() + j );
+      sky.insert( sky.begin() + i, Segment{ left, top, w } );
+      // merge neighbours of equal height
+      if (i+1 < (int)sky.size() && sky[i+1].y == top){
+        sky[i].width += sky[i+1].width;
+        sky.erase( sky.begin() + i + 1 );
+      }
+      if (i > 0 && sky[i-1].y == top){
+        sky[i-1].width += sky[i].width;
+        sky.erase( sky.begin() + i );
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    inline Pack::Result Pack::run() const {
+
+      Result result;
+      result.placement.resize( mRect.size() );
+      if (mRect.empty()) return result;
+
+      double W = mSheet.width + mSpacing, H = mSheet.height + mSpacing;
+      if (mSheet.width <= 0 || mSheet.height <= 0) throw std::invalid_argument("Error: No Stock Sheet.");
+
+      ///1. Largest first
+      std::vector<int> order( mRect.size() );
+      for (size_t i=0;i<order.size();++i) order[i] = i;
+      auto side = [this](int i){ return std::max( mRect[i].width, mRect[i].height ); };
+      std::stable_sort( order.begin(), order.end(), [&](int a, int b){ return side(a) > side(b); } );
+
+      ///2. Skyline bottom-left over the open sheets, opening new ones as needed
+      std::vector< std::vector<Segment> > sheets;
+      for (int idx : order){
+        const Rect& r = mRect[idx];
+        double w = r.width + mSpacing, h = r.height + mSpacing;
+        if ( !(w <= W && h <= H) && !(h <= W && w <= H) )
+          throw std::invalid_argument("Error: Part Larger Than Stock.");
+
+        bool done = false;
+        int first = std::max( 0, (int)sheets.size() - mOpen );
+        for (int s=first; s<=(int)sheets.size() && !done; ++s){
+          if (s == (int)sheets.size()) sheets.push_back( std::vector<Segment>( 1, Segment{0, 0, W} ) );
+          auto& sky = sheets[s];
+          double x = 0, y = 0, rx = 0, ry = 0;
+          int i = Find( sky, w, h, H, x, y );
+          int ri = Find( sky, h, w, H, rx, ry );
+          bool rotated = ri >= 0 && (i < 0 || ry < y || (ry == y && rx < x));
+          if (rotated) { i = ri; x = rx; y = ry; }
+          if (i < 0) continue;
+          Raise( sky, i, rotated ? h : w, y + (rotated ? w : h) );
+          result.placement[idx] = { s, rotated, {x, y} };
+          done = true;
+        }
+      }
+
+      ///3. Sheet count and utilization
+      result.sheets = sheets.size();
+      for (auto& r : mRect) result.area += r.width * r.height;
+      result.utilization = result.area / ( result.sheets * mSheet.width * mSheet.height );
+      return result;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_PACK_HEADER_INCLUDED */
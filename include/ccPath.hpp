@@ -0,0 +1,257 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccPath.hpp
+/// \brief Loops of connected edges and the order the tool visits them in
+
+#ifndef CC_PATH_HEADER_INCLUDED
+#define CC_PATH_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2
+
+namespace cc{
+
+  /// A chain of connected edges, cut in one pass
+  struct Loop{
+    std::vector<Vec2> points;   ///< vertices in order of travel (arcs contribute their ends)
+    double length = 0;          ///< cut length of the edges
+    bool bClosed = false;       ///< does the chain return to its first vertex?
+    std::vector<int> edges;     ///< edge from each vertex to the next, as the owner's index (~index if walked end to start)
+    double area = 0;            ///< signed enclosed area of a closed loop (counterclockwise positive)
+    int parent = -1;            ///< smallest closed loop enclosing this one, -1 if none
+    int depth = 0;              ///< number of closed loops enclosing this one
+
+    /// Is this a cutout (enclosed by an odd number of loops)?
+    bool hole() const { return depth & 1; }
+  };
+
+  /// \brief Sequencing of loops into a tool path
+  ///
+  /// A closed loop may be entered at any vertex and is left where it was
+  /// entered; an open chain is entered at either end and left at the other.
+  /// Loops are ordered by nearest neighbour on a uniform grid of entry
+  /// points, then improved by 2-opt (reversing runs of the order), then each
+  /// closed loop's entry is moved to the vertex nearest its neighbours in the path.
+  struct Path{
+
+    /// A visit to a loop
+    struct Stop{
+      int loop;
+      Vec2 in, out;
+    };
+
+    /// Order in which to cut loops
+    static std::vector<Stop> Plan( const std::vector<Loop>& loops );
+
+    /// Rapid travel distance between consecutive stops
+    static double Travel( const std::vector<Stop>& stops ){
+      double d = 0;
+      for (size_t i=1;i<stops.size();++i) d += (stops[i].in - stops[i-1].out).norm();
+      return d;
+    }
+
+    /// Rapid travel distance of the planned path through loops
+    static double Travel( const std::vector<Loop>& loops ){
+      return loops.size() < 2 ? 0 : Travel( Plan(loops) );
+    }
+
+    /// Set depth and parent of each loop from the polygons approximating the closed ones
+    /// (empty for open chains, which are placed by their first point), assuming loops do not cross
+    static void Classify( std::vector<Loop>& loops, const std::vector< std::vector<Vec2> >& polygons );
+
+    /// Longest run of stops reversed by 2-opt
+    static constexpr int Window = 64;
+  };
+
+    //--------------------------------------------------------------------------
+    inline std::vector<Path::Stop> Path::Plan( const std::vector<Loop>& loops ){
+
+      std::vector<Stop> result;
+      int n = loops.size();
+      if (n == 0) return result;
+
+      ///1. Grid of the points a loop can be entered at
+      struct Entry{ int loop, vertex; };
+      double x0 = 1e300, y0 = 1e300, x1 = -1e300, y1 = -1e300;
+      int count = 0;
+      for (auto& l : loops){
+        for (auto& v : l.points){
+          x0 = std::min(x0, v.x); x1 = std::max(x1, v.x);
+          y0 = std::min(y0, v.y); y1 = std::max(y1, v.y);
+        }
+        count += l.bClosed ? l.points.size() : 2;
+      }
+      int side = std::max( 1, (int)sqrt( (double)count ) );
+      double cw = std::max( (x1 - x0) / side, 1e-9 ), ch = std::max( (y1 - y0) / side, 1e-9 );
+      std::vector< std::vector<Entry> > grid( side * side );
+      auto cell = [&]( double v, double o, double s ){
+        return std::min( side-1, std::max( 0, (int)( (v - o) / s ) ) );
+      };
+      for (int i=0;i<n;++i){
+        auto& p = loops[i].points;
+        if (p.empty()) continue;
+        int m = p.size();
+        for (int k=0;k<m;++k){
+          if (!loops[i].bClosed && k != 0 && k != m-1) continue;
+          grid[ cell(p[k].y, y0, ch) * side + cell(p[k].x, x0, cw) ].push_back( { i, k } );
+        }
+      }
+
+      ///2. Nearest neighbour: search rings of cells until no closer entry can remain
+      std::vector<bool> visited( n, false );
+      auto stop = [&]( int i, int k ){
+        auto& p = loops[i].points;
+        if (loops[i].bClosed) return Stop{ i, p[k], p[k] };
+        return k == 0 ? Stop{ i, p.front(), p.back() } : Stop{ i, p.back(), p.front() };
+      };
+      Vec2 at = { x0, y0 };
+      for (int left = n; left > 0; --left){
+        int cx = cell(at.x, x0, cw), cy = cell(at.y, y0, ch);
+        double best = 1e300;
+        Entry pick = { -1, 0 };
+        for (int r=0; r<side; ++r){
+          if (pick.loop >= 0 && (r-1) * std::min(cw, ch) > best) break;
+          for (int gy = cy-r; gy <= cy+r; ++gy){
+            if (gy < 0 || gy >= side) continue;
+            for (int gx = cx-r; gx <= cx+r; ++gx){
+              if (gx < 0 || gx >= side) continue;
+              if (std::abs(gx-cx) != r && std::abs(gy-cy) != r) continue;
+              for (auto& e : grid[ gy*side + gx ]){
+                if (visited[e.loop]) continue;
+                double d = (loops[e.loop].points[e.vertex] - at).norm();
+                if (d < best) { best = d; pick = e; }
+              }
+            }
+          }
+        }
+        if (pick.loop < 0){
+          // loops without points
+          for (int i=0;i<n;++i) if (!visited[i]) { pick = { i, 0 }; break; }
+          visited[pick.loop] = true;
+          if (!loops[pick.loop].points.empty()) result.push_back( stop( pick.loop, 0 ) );
+          continue;
+        }
+        visited[pick.loop] = true;
+        result.push_back( stop( pick.loop, pick.vertex ) );
+        at = result.back().out;
+      }
+
+      ///3. 2-opt on the open path: reversing stops i+1..j swaps the ends of open chains
+      int m = result.size();
+      auto d = []( const Vec2& a, const Vec2& b ){ return (a - b).norm(); };
+      bool improved = true;
+      for (int pass=0; improved && pass<8; ++pass){
+        improved = false;
+        for (int i=-1; i<m-1; ++i){
+          for (int j=i+1; j<m && j<=i+Window; ++j){
+            double before = (i >= 0 ? d( result[i].out, result[i+1].in ) : 0)
+                          + (j+1 < m ? d( result[j].out, result[j+1].in ) : 0);
+            double after = (i >= 0 ? d( result[i].out, result[j].out ) : 0)
+                         + (j+1 < m ? d( result[i+1].in, result[j+1].in ) : 0);
+            if (after < before - 1e-12){
+              std::reverse( result.begin() + i+1, result.begin() + j+1 );
+              for (int k=i+1;k<=j;++k) std::swap( result[k].in, result[k].out );
+              improved = true;
+            }
+          }
+        }
+      }
+
+      ///4. Enter each closed loop at its vertex nearest the previous exit and next entry
+      for (int i=0;i<m;++i){
+        auto& l = loops[ result[i].loop ];
+        if (!l.bClosed || (i == 0 && m == 1)) continue;
+        auto legs = [&]( const Vec2& v ){
+          return (i > 0 ? d( result[i-1].out, v ) : 0) + (i+1 < m ? d( v, result[i+1].in ) : 0);
+        };
+        Vec2 best = result[i].in;
+        for (auto& v : l.points) if (legs(v) < legs(best)) best = v;
+        result[i].in = result[i].out = best;
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /// Classification implementation:
+    /// polygon edges are binned into horizontal bands, and one vertex of each
+    /// loop casts a ray in +x against the edges of its band only, toggling the
+    /// parity of every loop it crosses; loops crossed an odd number of times
+    /// enclose it.  Near linear when loops are spread over the part.
+    inline void Path::Classify( std::vector<Loop>& loops, const std::vector< std::vector<Vec2> >& polygons ){
+
+      int n = loops.size();
+      for (auto& l : loops) { l.parent = -1; l.depth = 0; }
+      if (n < 2) return;
+
+      ///1. Bands of polygon edges by y
+      struct Edge{ Vec2 p, q; int loop; };
+      std::vector<Edge> edges;
+      double y0 = 1e300, y1 = -1e300;
+      for (int i=0;i<n;++i){
+        auto& poly = polygons[i];
+        int m = poly.size();
+        if (!loops[i].bClosed || m < 3) continue;
+        for (int k=0;k<m;++k){
+          edges.push_back( { poly[k], poly[(k+1)%m], i } );
+          y0 = std::min(y0, poly[k].y); y1 = std::max(y1, poly[k].y);
+        }
+      }
+      if (edges.empty()) return;
+      int bands = std::max( 1, (int)sqrt( (double)edges.size() ) );
+      double h = std::max( (y1 - y0) / bands, 1e-12 );
+      auto band = [&]( double y ){ return std::min( bands-1, std::max( 0, (int)( (y - y0) / h ) ) ); };
+      std::vector< std::vector<int> > bin( bands );
+      for (int k=0;k<(int)edges.size();++k){
+        auto& e = edges[k];
+        for (int b = band( std::min(e.p.y, e.q.y) ); b <= band( std::max(e.p.y, e.q.y) ); ++b) bin[b].push_back(k);
+      }
+
+      ///2. Ray from a vertex of each loop (the first point of an open chain)
+      std::vector<char> parity( n, 0 );
+      std::vector<int> touched;
+      for (int i=0;i<n;++i){
+        if (polygons[i].empty() && loops[i].points.empty()) continue;
+        Vec2 v = polygons[i].empty() ? loops[i].points[0] : polygons[i][0];
+        touched.clear();
+        for (int k : bin[ band(v.y) ]){
+          auto& e = edges[k];
+          if (e.loop == i || (e.p.y > v.y) == (e.q.y > v.y)) continue;
+          double x = e.p.x + (v.y - e.p.y) * (e.q.x - e.p.x) / (e.q.y - e.p.y);
+          if (x <= v.x) continue;
+          if (!(parity[e.loop] & 2)) { touched.push_back(e.loop); parity[e.loop] |= 2; }
+          parity[e.loop] ^= 1;
+        }
+        for (int j : touched){
+          if (parity[j] & 1){
+            loops[i].depth++;
+            if (loops[i].parent < 0 || fabs(loops[j].area) < fabs(loops[ loops[i].parent ].area)) loops[i].parent = j;
+          }
+          parity[j] = 0;
+        }
+      }
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_PATH_HEADER_INCLUDED */
@@ -0,0 +1,528 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccService.hpp
+/// \brief Long-running quote service with admission control and deadlines
+
+#ifndef CC_SERVICE_HEADER_INCLUDED
+#define CC_SERVICE_HEADER_INCLUDED
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <sstream>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "ccData.hpp"       //< Analysis
+
+#include "ccCache.hpp"      //< Cross-process quote cache
+
+#include "ccSnapshot.hpp"   //< Warm start snapshots
+
+namespace cc{
+
+  /// Result of a quote request
+  struct Quote{
+
+    /// Outcome of a request
+    enum Status {
+      Ok,           ///< quote computed
+      Overloaded,   ///< rejected at admission: lane queue was full or service stopping
+      TooLarge,     ///< rejected after parsing: too many points to analyze
+      Expired,      ///< deadline passed, or the caller cancelled, while queued or during analysis
+      Invalid       ///< input could not be parsed
+    };
+
+    Status status = Ok;
+    double seconds = 0;     ///< machine time
+    double area = 0;        ///< padded material area
+    double cost = 0;        ///< cost in dollars
+    std::string error;      ///< description when status is not Ok
+  };
+
+  /// A quote request
+  struct Request{
+    std::string json;                       ///< part in files/Schema.json format
+    Profile profile;                        ///< pricing scenario
+    int resolution = 20;                    ///< discretization steps per arc
+    std::chrono::milliseconds deadline{0};  ///< time allowed, 0 uses Limits::deadline
+    const Cancel * cancel = nullptr;        ///< optional token the caller cancels to give up while queued
+                                            ///< or analyzing (not while sharing another's analysis)
+  };
+
+  /// Admission and scheduling limits of a QuoteService
+  struct Limits{
+    size_t queue = 64;              ///< capacity of each lane
+    size_t points = 250000;         ///< maximum points to discretize and hull
+    size_t small = 16384;           ///< requests under this many json bytes use the fast lane
+    int workers = 4;                ///< total worker threads
+    int fastWorkers = 1;            ///< workers serving only the fast lane
+    std::chrono::milliseconds deadline{2000};  ///< default time allowed per request
+  };
+
+  /// \class SingleFlight
+  /// \brief Coalesces concurrent computations of the same key
+  ///
+  /// The first caller to join a key leads the flight, computing under a
+  /// deadline, and must land() it; later callers with a deadline no earlier
+  /// hand over their promise and are answered by the leader.  A caller whose
+  /// deadline is earlier than the flight's computes alone, since the leader
+  /// would not stop in time for it.  A leader that runs out of time must not
+  /// pass that on to followers with time left: promote() answers only the
+  /// followers whose deadlines have passed, and hands the rest back to the
+  /// leader to compute again under the earliest of their deadlines.
+  template< class K, class V >
+  class SingleFlight {
+
+    public:
+
+      typedef Cancel::Clock Clock;
+
+      /// Outcome of join()
+      enum Role { Lead, Follow, Alone };
+
+    private:
+
+      /// Promise of a waiting caller and when it stops waiting
+      struct Follower{
+        std::promise<V> promise;
+        Clock::time_point deadline;
+      };
+
+      /// Deadline of the current computation and the followers waiting on it
+      struct Flight{
+        Clock::time_point deadline;
+        std::vector<Follower> followers;
+      };
+
+      std::mutex mMutex;
+      std::unordered_map< K, Flight > mFlight;
+
+    public:
+
+      /// Join the flight of key with a deadline
+      /// \returns Lead or Alone if the caller computes, Follow if promise has been attached
+      Role join( const K& key, std::promise<V>& promise, Clock::time_point deadline ){
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mFlight.find(key);
+        if (it == mFlight.end()){
+          mFlight[key].deadline = deadline;
+          return Lead;
+        }
+        if (deadline < it->second.deadline) return Alone;
+        it->second.followers.push_back( { std::move(promise), deadline } );
+        return Follow;
+      }
+
+      /// Complete the flight of key, answering every follower with value
+      void land( const K& key, const V& value ){
+        std::vector<Follower> followers;
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+          auto it = mFlight.find(key);
+          if (it == mFlight.end()) return;
+          followers.swap(it->second.followers);
+          mFlight.erase(it);
+        }
+        for (auto& i : followers) i.promise.set_value(value);
+      }
+
+      /// After the leader's deadline passed: answer followers out of time at
+      /// now with expired, and keep the flight for the rest
+      /// \returns true with deadline set to the earliest left if the leader should compute again,
+      /// false if no follower is left and the flight has landed
+      bool promote( const K& key, const V& expired, Clock::time_point& deadline, Clock::time_point now = Clock::now() ){
+        std::vector<Follower> late;
+        bool again = false;
+        {
+          std::lock_guard<std::mutex> lock(mMutex);
+          auto it = mFlight.find(key);
+          if (it == mFlight.end()) return false;
+          auto& waiting = it->second.followers;
+          std::vector<Follower> left;
+          for (auto& i : waiting) (i.deadline < now ? late : left).push_back( std::move(i) );
+          waiting.swap(left);
+          if (waiting.empty()) mFlight.erase(it);
+          else {
+            again = true;
+            deadline = waiting[0].deadline;
+            for (auto& i : waiting) if (i.deadline < deadline) deadline = i.deadline;
+            it->second.deadline = deadline;
+          }
+        }
+        for (auto& i : late) i.promise.set_value(expired);
+        return again;
+      }
+
+      /// Number of keys in flight
+      size_t size() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mFlight.size();
+      }
+  };
+
+  /// \class QuoteService
+  /// \brief Bounded, deadline-aware pool of workers running Data analysis
+  ///
+  /// Requests are admitted into one of two bounded lanes by size, so a huge
+  /// upload never queues in front of small parts: fast workers serve only the
+  /// small lane, the rest prefer it and fall back to the large lane.  Full
+  /// lanes answer Overloaded immediately.  Each request's deadline is checked
+  /// at dequeue, its point count is checked right after parsing, and the
+  /// deadline is polled inside discretize/Convex/MinimumBox through a Cancel token.
+  /// Concurrent requests for the same canonical geometry, resolution and profile
+  /// are coalesced: later ones attach to the first and share its outcome,
+  /// and are answered Expired only once their own deadline has passed.
+  /// An optional SharedCache is consulted before, and filled after, analysis,
+  /// backed by an optional Snapshot mapped at startup; the cache can be written
+  /// to a snapshot file periodically and on shutdown for the next process.
+  class QuoteService {
+
+    public:
+
+      typedef Cancel::Clock Clock;
+
+    private:
+
+      /// Admitted request awaiting a worker
+      struct Job{
+        Request request;
+        Clock::time_point deadline;
+        std::promise<Quote> promise;
+      };
+
+      Limits mLimits;
+
+      /// Small and large lanes
+      std::deque<Job> mFast, mSlow;
+
+      std::mutex mMutex;
+      std::condition_variable mReady;
+      bool bStop = false;
+      bool bHeld = false;
+
+      std::vector<std::thread> mWorker;
+
+      /// In-flight analyses by Key()
+      SingleFlight<uint64_t,Quote> mFlight;
+
+      /// Optional cache shared with other processes
+      SharedCache * mCache = nullptr;
+
+      /// Optional snapshot from a previous run
+      const Snapshot * mWarm = nullptr;
+
+      /// Periodic snapshot writer
+      std::thread mSnapshotter;
+      std::condition_variable mStopped;
+      std::string mSnapshotPath;
+      const SummaryStore * mSnapshotStore = nullptr;
+      std::string mSnapshotError;
+
+      /// Worker loop
+      void work( bool fastOnly );
+
+      /// Analyze one admitted job and answer its promise
+      void run( Job& job );
+
+      /// Write the snapshot, keeping its error
+      void write();
+
+      /// Answer a job without analysis
+      static void Answer( Job& job, Quote::Status status, std::string error ){
+        Quote q; q.status = status; q.error = error;
+        job.promise.set_value(q);
+      }
+
+      /// A future already holding a rejection
+      static std::future<Quote> Reject( Quote::Status status, std::string error ){
+        std::promise<Quote> p;
+        Quote q; q.status = status; q.error = error;
+        p.set_value(q);
+        return p.get_future();
+      }
+
+    public:
+
+      /// Start workers
+      QuoteService( const Limits& limits = Limits() );
+
+      /// Stop workers; queued requests are answered Overloaded
+      ~QuoteService();
+
+      /// Set a cache shared with other worker processes (call before submitting)
+      void cache( SharedCache * c ) { mCache = c; }
+
+      /// Set a snapshot to answer from until the cache warms up (call before submitting)
+      void warm( const Snapshot * s ) { mWarm = s; }
+
+      /// Write the cache (and optional hot summaries) to path every interval and on shutdown
+      /// (requires cache(); call once)
+      void snapshot( std::string path, std::chrono::seconds interval, const SummaryStore * store = nullptr );
+
+      /// Write the snapshot now, as the periodic writer does (requires snapshot())
+      void snapshotNow();
+
+      /// Error of the latest snapshot write, empty if it succeeded (or none was written yet)
+      std::string snapshotError() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mSnapshotError;
+      }
+
+      /// Admit a request
+      /// \returns future quote (immediately Overloaded if its lane is full)
+      std::future<Quote> submit( Request request );
+
+      /// Hold workers from taking queued requests, or release them
+      /// (requests are still admitted while held, up to the lane capacity)
+      void hold( bool held );
+
+      /// Version of the quote model, part of every Key(): bump it with any change
+      /// that quotes the same input differently, so cached and snapshot quotes of
+      /// the old model are missed rather than served.  Each version names the
+      /// changes it covers:
+      ///   1: rapid travel between loops (037), welding on read (043), arc
+      ///      sweeps past a half turn (045), circles boxed at 2r (049);
+      ///   2: arcs on one vertex (041) and arcs welded shut (043) cut as full circles.
+      static constexpr uint32_t Model = 2;
+
+      /// Key of a quote: model version, canonical geometry hash, resolution and profile
+      static uint64_t Key( uint64_t geometry, int resolution, const Profile& f ){
+        uint64_t h = Hash::Combine( Hash::Mix(Model), geometry );
+        h = Hash::Combine( h, Hash::Mix(resolution) );
+        h = Hash::Combine( h, Hash::Of(f.perSecond) );
+        h = Hash::Combine( h, Hash::Of(f.perUnitArea) );
+        h = Hash::Combine( h, Hash::Of(f.velocity) );
+        h = Hash::Combine( h, Hash::Of(f.falloff) );
+        h = Hash::Combine( h, Hash::Of(f.rapid) );
+        h = Hash::Combine( h, Hash::Of(f.acceleration) );
+        h = Hash::Combine( h, Hash::Of(f.deviation) );
+        h = Hash::Combine( h, Hash::Of(f.kerf) );
+        return Hash::Combine( h, Hash::Of(f.padding) );
+      }
+
+      /// Check of a quote, stored beside its Key() and compared on every hit:
+      /// of the same request by other functions (Data::check() and FNV-1a), so
+      /// a chance match of keys is not served as the other part's quote
+      static uint64_t Check( uint64_t geometry, int resolution, const Profile& f ){
+        double d[] = { (double)Model, (double)resolution, f.perSecond, f.perUnitArea, f.velocity, f.falloff,
+                       f.rapid, f.acceleration, f.deviation, f.kerf, f.padding };
+        for (auto& i : d) i += 0.0;
+        uint64_t c[2] = { geometry, Hash::Bytes( d, sizeof(d) ) };
+        return Hash::Bytes( c, sizeof(c) );
+      }
+
+      /// Number of requests waiting in the fast and slow lanes
+      size_t queued() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mFast.size() + mSlow.size();
+      }
+  };
+
+    //--------------------------------------------------------------------------
+    inline QuoteService::QuoteService( const Limits& limits )
+    : mLimits(limits)
+    {
+      int n = mLimits.workers > 0 ? mLimits.workers : 1;
+      int fast = mLimits.fastWorkers < n ? mLimits.fastWorkers : n-1;
+      for (int i=0;i<n;++i){
+        mWorker.push_back( std::thread( &QuoteService::work, this, i < fast ) );
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    inline QuoteService::~QuoteService(){
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        bStop = true;
+      }
+      mReady.notify_all();
+      mStopped.notify_all();
+      for (auto& i : mWorker) i.join();
+      if (mSnapshotter.joinable()) mSnapshotter.join();
+      for (auto* lane : { &mFast, &mSlow }){
+        for (auto& j : *lane){
+          Quote q; q.status = Quote::Overloaded; q.error = "Error: Service Stopped.";
+          j.promise.set_value(q);
+        }
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    inline void QuoteService::snapshot( std::string path, std::chrono::seconds interval, const SummaryStore * store ){
+      if (!mCache) throw std::invalid_argument("Error: Snapshot Requires A Cache.");
+      mSnapshotPath = path;
+      mSnapshotStore = store;
+      mSnapshotter = std::thread( [this, interval]{
+        std::unique_lock<std::mutex> lock(mMutex);
+        bool stop = false;
+        while (!stop){
+          stop = mStopped.wait_for( lock, interval, [this]{ return bStop; } );
+          lock.unlock();
+          write();
+          lock.lock();
+        }
+      });
+    }
+
+    //--------------------------------------------------------------------------
+    inline void QuoteService::snapshotNow(){
+      if (mSnapshotPath.empty()) throw std::invalid_argument("Error: No Snapshot To Write.");
+      write();
+    }
+
+    //--------------------------------------------------------------------------
+    inline void QuoteService::write(){
+      std::string error;
+      try { Snapshot::Write( mSnapshotPath, *mCache, mSnapshotStore ); }
+      catch (std::exception& e) { error = e.what(); }
+      std::lock_guard<std::mutex> lock(mMutex);
+      mSnapshotError = error;
+    }
+
+    //--------------------------------------------------------------------------
+    inline std::future<Quote> QuoteService::submit( Request request ){
+
+      auto allowed = request.deadline.count() > 0 ? request.deadline : mLimits.deadline;
+      bool small = request.json.size() < mLimits.small;
+
+      std::unique_lock<std::mutex> lock(mMutex);
+      if (bStop) return Reject( Quote::Overloaded, "Error: Service Stopped." );
+      auto& lane = small ? mFast : mSlow;
+      if (lane.size() >= mLimits.queue) return Reject( Quote::Overloaded, "Error: Queue Full." );
+
+      lane.push_back( Job() );
+      auto& job = lane.back();
+      job.request = std::move(request);
+      job.deadline = Clock::now() + allowed;
+      auto result = job.promise.get_future();
+      lock.unlock();
+
+      // wake everyone: a slow-lane job is invisible to fast-only workers
+      mReady.notify_all();
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    inline void QuoteService::hold( bool held ){
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        bHeld = held;
+      }
+      mReady.notify_all();
+    }
+
+    //--------------------------------------------------------------------------
+    inline void QuoteService::work( bool fastOnly ){
+      while (true){
+        Job job;
+        {
+          std::unique_lock<std::mutex> lock(mMutex);
+          mReady.wait( lock, [&]{
+            return bStop || (!bHeld && (!mFast.empty() || (!fastOnly && !mSlow.empty())));
+          });
+          if (bStop) return;
+          auto& lane = !mFast.empty() ? mFast : mSlow;
+          job = std::move( lane.front() );
+          lane.pop_front();
+        }
+        run(job);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    inline void QuoteService::run( Job& job ){
+
+      ///1. Shed requests that waited past their deadline, or were cancelled
+      if (Clock::now() > job.deadline){
+        return Answer( job, Quote::Expired, "Error: Deadline Passed In Queue." );
+      }
+      if (job.request.cancel && job.request.cancel->expired()){
+        return Answer( job, Quote::Expired, "Error: Cancelled In Queue." );
+      }
+
+      ///2. Parse, then check size before any discretization or hulling
+      Data data;
+      data.resolution( job.request.resolution );
+      try {
+        std::istringstream stream( job.request.json );
+        data.read( stream );
+      } catch (std::exception& e) {
+        return Answer( job, Quote::Invalid, e.what() );
+      }
+      if (data.points() > mLimits.points){
+        return Answer( job, Quote::TooLarge, "Error: Too Many Points." );
+      }
+
+      ///3. Answer from the shared cache, or the snapshot of a previous run,
+      /// if the entry's check agrees as well as its key
+      uint64_t key = Key( data.hash(), job.request.resolution, job.request.profile );
+      uint64_t check = Check( data.check(), job.request.resolution, job.request.profile );
+      SharedCache::Value v;
+      bool cached = mCache && mCache->find( key, v ) && v.check == check;
+      if (!cached && mWarm && mWarm->find( key, v ) && v.check == check){
+        cached = true;
+        if (mCache) mCache->insert( key, v );
+      }
+      if (cached){
+        Quote q; q.seconds = v.seconds; q.area = v.area; q.cost = v.cost;
+        return job.promise.set_value(q);
+      }
+
+      ///4. Attach to an identical analysis already in flight, unless it would outlast our deadline
+      auto role = mFlight.join( key, job.promise, job.deadline );
+      if (role == SingleFlight<uint64_t,Quote>::Follow) return;
+
+      ///5. Analyze under the deadline (and the caller's token), again under the
+      /// followers' deadlines if ours passes first
+      auto& f = job.request.profile;
+      auto deadline = job.deadline;
+      bool answered = false;
+      while (true){
+        Quote q;
+        Cancel token( deadline, answered ? nullptr : job.request.cancel );
+        data.cancel( &token );
+        try {
+          q.seconds = data.seconds(f);
+          q.area = data.area(f);
+          q.cost = q.seconds * f.perSecond + q.area * f.perUnitArea;
+        } catch (Cancelled& e) {
+          q.status = Quote::Expired; q.error = e.what();
+        } catch (std::exception& e) {
+          q.status = Quote::Invalid; q.error = e.what();
+        }
+        data.cancel( nullptr );
+        if (mCache && q.status == Quote::Ok) mCache->insert( key, { q.seconds, q.area, q.cost, check } );
+        if (!answered) job.promise.set_value(q);
+        answered = true;
+        if (role == SingleFlight<uint64_t,Quote>::Alone) return;
+        if (q.status != Quote::Expired) return mFlight.land( key, q );
+        if (!mFlight.promote( key, q, deadline )) return;
+      }
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_SERVICE_HEADER_INCLUDED */
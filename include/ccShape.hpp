@@ -0,0 +1,149 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccShape.hpp
+/// \brief Recognition of parts simple enough to quote in closed form
+
+#ifndef CC_SHAPE_HEADER_INCLUDED
+#define CC_SHAPE_HEADER_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2, Hull
+#include "ccMacros.hpp"     //< PI
+#include "ccOffset.hpp"     //< Piece
+#include "ccSmall.hpp"      //< Small::MinimumBox
+
+namespace cc{
+
+  /// \brief Closed forms of a part made of a single closed loop
+  ///
+  /// A loop of straight pieces turning one way throughout is its own convex
+  /// hull, so its vertices can go to the calipers as they are, without
+  /// discretizing or sorting; if it has four right angles it is a rectangle,
+  /// its own minimum box.  A loop of arcs about one center sweeping one full
+  /// turn (a single arc closing on itself among them) is a circle, boxed by
+  /// its diameter: the exact box at any resolution, which the box of the
+  /// discretized circle approaches from below.  Anything else is General and
+  /// takes the full path.
+  struct Shape{
+
+    enum Kind{ General, Rectangle, Circle, Convex };
+
+    Kind kind = General;
+    std::vector<Vec2> hull;     ///< vertices counterclockwise, without collinear ones (Rectangle and Convex)
+    double width = 0;           ///< sides of the minimum box (Rectangle and Circle)
+    double height = 0;
+    double radius = 0;          ///< radius of a Circle
+    double length = 0;          ///< cut length of the loop
+
+    /// Is the part quoted in closed form?
+    bool closed() const { return kind != General; }
+
+    /// Minimum box: sides in closed form for rectangles and circles, calipers on the vertices of convex polygons
+    Hull::Box box( const Cancel * cancel = nullptr ) const {
+      if (kind == Convex) return Small::MinimumBox( hull, cancel );
+      Hull::Box b;
+      const Vec2 para[4] = { {0,-1}, {0,1}, {1,0}, {-1,0} };
+      for (int j=0;j<4;++j) { b.para[j] = para[j]; b.idx[j] = 0; }
+      b.width = width;
+      b.height = height;
+      if (kind == Rectangle){
+        // lines along the sides, through the vertex starting each, as the calipers leave them
+        Vec2 u = (hull[1] - hull[0]).unit();
+        Vec2 v = { -u.y, u.x };
+        const Vec2 side[4] = { u, Vec2{ -u.x, -u.y }, v, Vec2{ -v.x, -v.y } };
+        const int at[4] = { 0, 2, 1, 3 };
+        for (int j=0;j<4;++j) { b.para[j] = side[j]; b.idx[j] = at[j]; }
+      }
+      return b;
+    }
+
+    /// Recognize the pieces of one closed loop, in order of travel
+    /// \param tolerance distance within which centers and radii of arcs agree
+    static Shape Classify( const std::vector<Piece>& pieces, double tolerance );
+  };
+
+    //--------------------------------------------------------------------------
+    inline Shape Shape::Classify( const std::vector<Piece>& pieces, double tolerance ){
+
+      Shape s;
+      int n = pieces.size();
+      if (n < 1) return s;
+      int arcs = 0;
+      for (auto& p : pieces) { s.length += p.length(); if (p.arc()) arcs++; }
+
+      ///1. Arcs about one center, turning one way through a full turn
+      if (arcs == n){
+        const Vec2& c = pieces[0].center;
+        double r = pieces[0].radius(), sweep = 0;
+        double tol = tolerance + 1e-9 * r;
+        for (auto& p : pieces){
+          if ((p.center - c).norm() > tol || fabs( p.radius() - r ) > tol) return s;
+          if ((p.sweep > 0) != (pieces[0].sweep > 0)) return s;
+          sweep += p.sweep;
+        }
+        if (fabs( fabs(sweep) - 2*PI ) > 1e-6) return s;
+        s.kind = Circle;
+        s.radius = r;
+        s.width = s.height = 2*r;
+        return s;
+      }
+      if (arcs > 0 || n < 3) return s;
+
+      ///2. Straight pieces turning one way through one turn (not a star):
+      /// drop collinear vertices, then orient counterclockwise
+      double area = 0, turn = 0;
+      for (int i=0;i<n;++i) area += Vec2::Cross( pieces[i].a, pieces[i].b );
+      double sign = area > 0 ? 1 : -1;
+      for (int i=0;i<n;++i){
+        Vec2 e0 = pieces[ (i + n - 1) % n ].b - pieces[ (i + n - 1) % n ].a;
+        Vec2 e1 = pieces[i].b - pieces[i].a;
+        double c = sign * Vec2::Cross( e0, e1 ), l = e0.norm() * e1.norm();
+        if (c < -1e-9 * l) { s.hull.clear(); return s; }
+        if (c > 1e-9 * l) s.hull.push_back( pieces[i].a );
+        turn += atan2( c, Vec2::Dot( e0, e1 ) );
+      }
+      if (s.hull.size() < 3 || fabs( turn - 2*PI ) > 1e-6) { s.hull.clear(); return s; }
+      if (sign < 0) std::reverse( s.hull.begin(), s.hull.end() );
+      s.kind = Convex;
+
+      ///3. Four right angles make a rectangle
+      if (s.hull.size() == 4){
+        bool square = true;
+        for (int i=0;i<4;++i){
+          Vec2 e0 = s.hull[(i+1)%4] - s.hull[i], e1 = s.hull[(i+2)%4] - s.hull[(i+1)%4];
+          if (fabs( Vec2::Dot( e0, e1 ) ) > 1e-9 * e0.norm() * e1.norm()) square = false;
+        }
+        if (square){
+          s.kind = Rectangle;
+          // width across the first side, as Hull::MinimumBox measures it
+          s.width = (s.hull[2] - s.hull[1]).norm();
+          s.height = (s.hull[1] - s.hull[0]).norm();
+        }
+      }
+      return s;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_SHAPE_HEADER_INCLUDED */
@@ -0,0 +1,117 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccSimplify.hpp
+/// \brief Bounded-error reduction of polylines before hulling
+
+#ifndef CC_SIMPLIFY_HEADER_INCLUDED
+#define CC_SIMPLIFY_HEADER_INCLUDED
+
+#include <vector>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2, Hull::Box
+#include "ccMacros.hpp"     //< PI
+
+namespace cc{
+
+  /// \brief Douglas–Peucker reduction of ordered points
+  ///
+  /// Keeps the ends of a chain and, while some point lies farther than
+  /// tolerance from the segment between kept neighbours, keeps the farthest
+  /// one.  A closed loop is split at its first point and the point farthest
+  /// from it.  Runs on an explicit stack, so long chains cannot overflow.
+  ///
+  /// Every dropped point lies within tolerance of the reduced chain, so the
+  /// convex hull of the reduced points, grown by tolerance, contains the
+  /// original hull: its area is short by at most Bound(), and that of its
+  /// minimum box by at most the Bound() of the reduced box.
+  struct Simplify{
+
+    /// Reduce a chain of points (closed if the last point joins the first)
+    static std::vector<Vec2> Polyline( const std::vector<Vec2>& points, double tolerance, bool closed );
+
+    /// Most area a convex hull of given perimeter can lose when its points are reduced within tolerance
+    static double Bound( double perimeter, double tolerance ){
+      return perimeter * tolerance + PI * tolerance * tolerance;
+    }
+
+    /// Most area the minimum box of a hull can lose, given the box of its reduced points:
+    /// the original hull fits in that box grown by tolerance on every side
+    static double Bound( const Hull::Box& box, double tolerance ){
+      return 2 * tolerance * (box.width + box.height) + 4 * tolerance * tolerance;
+    }
+  };
+
+    //--------------------------------------------------------------------------
+    inline std::vector<Vec2> Simplify::Polyline( const std::vector<Vec2>& points, double tolerance, bool closed ){
+
+      int n = points.size();
+      if (n < 3 || tolerance <= 0) return points;
+
+      // distance of p from the segment ab
+      auto distance = []( const Vec2& p, const Vec2& a, const Vec2& b ){
+        Vec2 d = b - a;
+        double l2 = Vec2::Dot(d, d);
+        if (l2 <= 0) return (p - a).norm();
+        double t = std::max( 0.0, std::min( 1.0, Vec2::Dot(p - a, d) / l2 ) );
+        return (p - (a + Vec2{ d.x * t, d.y * t })).norm();
+      };
+
+      ///1. Ends of the chain: a closed loop runs from its first point back to it,
+      /// through the point farthest from it
+      std::vector<bool> keep( n+1, false );
+      auto at = [&]( int i ) -> const Vec2& { return points[ i % n ]; };
+      std::vector< std::pair<int,int> > stack;
+      keep[0] = true;
+      if (closed){
+        int far = 0;
+        for (int i=1;i<n;++i) if ((points[i] - points[0]).norm() > (points[far] - points[0]).norm()) far = i;
+        keep[far] = true;
+        stack.push_back( { 0, far } );
+        stack.push_back( { far, n } );
+      } else {
+        keep[n-1] = true;
+        stack.push_back( { 0, n-1 } );
+      }
+
+      ///2. Split each span at its farthest point until all are within tolerance
+      while (!stack.empty()){
+        auto s = stack.back(); stack.pop_back();
+        int far = -1;
+        double dmax = tolerance;
+        for (int i=s.first+1;i<s.second;++i){
+          double d = distance( at(i), at(s.first), at(s.second) );
+          if (d > dmax) { dmax = d; far = i; }
+        }
+        if (far < 0) continue;
+        keep[far] = true;
+        stack.push_back( { s.first, far } );
+        stack.push_back( { far, s.second } );
+      }
+
+      std::vector<Vec2> result;
+      for (int i=0;i<n;++i) if (keep[i]) result.push_back( points[i] );
+      return result;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_SIMPLIFY_HEADER_INCLUDED */
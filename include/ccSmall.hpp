@@ -0,0 +1,180 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccSmall.hpp
+/// \brief Hull and minimum box kernels for clouds of a few dozen points
+
+#ifndef CC_SMALL_HEADER_INCLUDED
+#define CC_SMALL_HEADER_INCLUDED
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2, Hull, Cancel
+
+namespace cc{
+
+  /// \brief Fixed capacity hull kernels
+  ///
+  /// Typical parts hull to a few dozen points, where the copy and the
+  /// growing chains of Hull::Convex cost as much as the sort.  Here the
+  /// points are sorted and chained in std::arrays of N slots on the stack,
+  /// with one allocation for the result, which is the same loop of points
+  /// Hull::Convex returns.  (A bitonic sorting network over the padded slots
+  /// measured slower than std::sort at every size up to Max.)
+  ///
+  /// The minimum box walks the edges of the hull with three support
+  /// pointers (farthest across the edge, and both ends along it), using dot
+  /// products against edge directions computed once, with no trigonometry;
+  /// the rotating calipers of Hull::MinimumBox take a rotate() (an atan2, a
+  /// sine and a cosine) per line per step.  As with Hull::MinimumBox the
+  /// axis aligned box stands unless an edge's box is smaller.
+  ///
+  /// Convex() and MinimumBox() pick the smallest capacity that fits, and
+  /// fall back to Hull beyond Max points.
+  struct Small{
+
+    /// Largest input handled on the stack
+    static constexpr int Max = 64;
+
+    /// Convex hull of at most N points, as Hull::Convex
+    template< int N >
+    static std::vector<Vec2> Convex( const std::vector<Vec2>& input );
+
+    /// Minimum box of a counterclockwise convex loop of at most N points, as Hull::MinimumBox
+    template< int N >
+    static Hull::Box MinimumBox( const std::vector<Vec2>& hull );
+
+    /// Convex hull, on the stack if the input is small
+    static std::vector<Vec2> Convex( std::vector<Vec2>& input, const Cancel * cancel = nullptr ){
+      size_t n = input.size();
+      if (n <= 16) return Convex<16>( input );
+      if (n <= 32) return Convex<32>( input );
+      if (n <= (size_t)Max) return Convex<Max>( input );
+      return Hull::Convex( input, cancel );
+    }
+
+    /// Minimum box of a convex loop, without trigonometry if it is small
+    static Hull::Box MinimumBox( const std::vector<Vec2>& hull, const Cancel * cancel = nullptr ){
+      size_t n = hull.size();
+      if (n <= 16) return MinimumBox<16>( hull );
+      if (n <= 32) return MinimumBox<32>( hull );
+      if (n <= (size_t)Max) return MinimumBox<Max>( hull );
+      return Hull::MinimumBox( hull, cancel );
+    }
+  };
+
+    //--------------------------------------------------------------------------
+    template< int N >
+    inline std::vector<Vec2> Small::Convex( const std::vector<Vec2>& input ){
+
+      std::vector<Vec2> result;
+      int n = input.size();
+      if (n == 0) return result;
+      if (n > N) { result = input; return Hull::Convex( result ); }
+
+      ///1. Copy onto the stack and sort by x and then by y
+      std::array<Vec2,N> p;
+      std::copy( input.begin(), input.end(), p.begin() );
+      std::sort( p.begin(), p.begin() + n );
+
+      ///2. Lower and upper chains on the stack
+      std::array<Vec2,N> lower, upper;
+      int lo = 0, up = 0;
+      for (int i=0;i<n;++i){
+        while (lo >= 2 && Vec2::Cross( lower[lo-1] - lower[lo-2], p[i] - lower[lo-2] ) <= 0) lo--;
+        lower[lo++] = p[i];
+      }
+      for (int i=n-1;i>=0;--i){
+        while (up >= 2 && Vec2::Cross( upper[up-1] - upper[up-2], p[i] - upper[up-2] ) <= 0) up--;
+        upper[up++] = p[i];
+      }
+
+      ///3. Each chain without its last point (the first of the other)
+      result.reserve( lo + up - 2 );
+      result.insert( result.end(), lower.begin(), lower.begin() + lo - 1 );
+      result.insert( result.end(), upper.begin(), upper.begin() + up - 1 );
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    template< int N >
+    inline Hull::Box Small::MinimumBox( const std::vector<Vec2>& hull ){
+
+      Hull::Box box = Hull::Box();
+      int n = hull.size();
+      if (n < 3) return box;
+      if (n > N) return Hull::MinimumBox( hull );
+      auto next = [n]( int i ){ return i + 1 < n ? i + 1 : 0; };
+
+      ///1. Axis aligned box, with the supports Hull::MinimumBox starts from
+      int idx[4] = { 0, 0, 0, 0 };
+      for (int i=1;i<n;++i){
+        if (hull[i].x < hull[idx[0]].x) idx[0] = i;
+        if (hull[i].x > hull[idx[1]].x) idx[1] = i;
+        if (hull[i].y < hull[idx[2]].y) idx[2] = i;
+        if (hull[i].y > hull[idx[3]].y) idx[3] = i;
+      }
+      const Vec2 axis[4] = { {0,-1}, {0,1}, {1,0}, {-1,0} };
+      box.width = hull[idx[1]].x - hull[idx[0]].x;
+      box.height = hull[idx[3]].y - hull[idx[2]].y;
+      for (int j=0;j<4;++j) { box.para[j] = axis[j]; box.idx[j] = idx[j]; }
+      double minArea = box.width * box.height;
+
+      ///2. Edge directions, once
+      std::array<Vec2,N> u;
+      for (int i=0;i<n;++i) u[i] = (hull[next(i)] - hull[i]).unit();
+
+      ///3. Box flush with each edge: supports only move forward around the loop
+      int far = 0, front = 0, back = 0;
+      for (int i=0;i<n;++i){
+        const Vec2& e = u[i];
+        Vec2 v = { -e.y, e.x };   // inward normal of a counterclockwise loop
+        if (i == 0){
+          for (int k=1;k<n;++k){
+            if (Vec2::Dot( v, hull[k] ) > Vec2::Dot( v, hull[far] )) far = k;
+            if (Vec2::Dot( e, hull[k] ) > Vec2::Dot( e, hull[front] )) front = k;
+            if (Vec2::Dot( e, hull[k] ) < Vec2::Dot( e, hull[back] )) back = k;
+          }
+        } else {
+          for (int s=0; s<n && Vec2::Dot( v, hull[next(far)] ) > Vec2::Dot( v, hull[far] ); ++s) far = next(far);
+          for (int s=0; s<n && Vec2::Dot( e, hull[next(front)] ) > Vec2::Dot( e, hull[front] ); ++s) front = next(front);
+          for (int s=0; s<n && Vec2::Dot( e, hull[next(back)] ) < Vec2::Dot( e, hull[back] ); ++s) back = next(back);
+        }
+        double width = Vec2::Dot( v, hull[far] - hull[i] );
+        double height = Vec2::Dot( e, hull[front] - hull[back] );
+        if (width * height < minArea){
+          minArea = width * height;
+          box.width = width;
+          box.height = height;
+          box.para[0] = e;                    box.idx[0] = i;
+          box.para[1] = Vec2{ -e.x, -e.y };   box.idx[1] = far;
+          box.para[2] = v;                    box.idx[2] = front;
+          box.para[3] = Vec2{ -v.x, -v.y };   box.idx[3] = back;
+        }
+      }
+      return box;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_SMALL_HEADER_INCLUDED */
@@ -0,0 +1,251 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccSnapshot.hpp
+/// \brief Memory mapped snapshot of cached quotes and summaries for warm starts
+
+#ifndef CC_SNAPSHOT_HEADER_INCLUDED
+#define CC_SNAPSHOT_HEADER_INCLUDED
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ccGeometry.hpp"   //< Hash
+#include "ccSummary.hpp"    //< Summary, SummaryStore
+#include "ccCache.hpp"      //< SharedCache
+
+namespace cc{
+
+  /// \class Snapshot
+  /// \brief Read-only, memory mapped file of quotes and summaries sorted by key
+  ///
+  /// Opening only maps the file and checks its header, so a restarted process
+  /// can answer from it within milliseconds.  Each entry carries its own
+  /// checksum which is verified when the entry is looked up; a corrupt entry
+  /// is treated as a miss.  Write() produces a new file atomically (write to a
+  /// temporary file unique to the writer, flush it to disk, then rename) so
+  /// readers never see a partial snapshot, even after a crash, and concurrent
+  /// writers never share a temporary file.
+  class Snapshot {
+
+    public:
+
+      /// Cached quote entry
+      struct Entry{
+        uint64_t key;
+        SharedCache::Value value;
+        uint64_t check;
+      };
+
+      /// Summary entry
+      struct Record{
+        uint64_t key;
+        Summary summary;
+        uint64_t check;
+      };
+
+    private:
+
+      /// File header
+      struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t runs;          ///< Summary::Runs of the writer
+        uint64_t quotes;        ///< number of Entry records
+        uint64_t records;       ///< number of Record entries
+        uint64_t check;         ///< checksum of the fields above
+      };
+
+      static constexpr uint32_t Version = 5;
+
+      void * mMap = nullptr;
+      size_t mBytes = 0;
+      const Entry * mEntry = nullptr;
+      const Record * mRecord = nullptr;
+      size_t mEntries = 0, mRecords = 0;
+
+      template< class T >
+      static uint64_t Check( const T& t ){
+        return Hash::Bytes( &t, offsetof(T, check) );
+      }
+
+      template< class T >
+      static const T * Search( const T * begin, size_t n, uint64_t key ){
+        auto it = std::lower_bound( begin, begin+n, key,
+          [](const T& e, uint64_t k){ return e.key < k; } );
+        if (it == begin+n || it->key != key || it->check != Check(*it)) return nullptr;
+        return it;
+      }
+
+      void close(){
+        if (mMap) munmap( mMap, mBytes );
+        mMap = nullptr; mBytes = 0; mEntries = mRecords = 0;
+      }
+
+    public:
+
+      Snapshot() {}
+
+      /// Map a snapshot file (a missing file leaves the snapshot empty)
+      Snapshot( std::string path ) { open(path); }
+
+      ~Snapshot() { close(); }
+
+      Snapshot( const Snapshot& ) = delete;
+      Snapshot& operator=( const Snapshot& ) = delete;
+
+      /// Map a snapshot file
+      /// \returns false if missing or its header does not match this build
+      bool open( std::string path );
+
+      /// Cached quote of key, verified on access
+      bool find( uint64_t key, SharedCache::Value& value ) const {
+        auto e = Search( mEntry, mEntries, key );
+        if (e) value = e->value;
+        return e != nullptr;
+      }
+
+      /// Summary of key, verified on access
+      /// \returns pointer into the mapped file or nullptr
+      const Summary * summary( uint64_t key ) const {
+        auto e = Search( mRecord, mRecords, key );
+        return e ? &e->summary : nullptr;
+      }
+
+      /// Number of quotes and summaries
+      size_t quotes() const { return mEntries; }
+      size_t summaries() const { return mRecords; }
+
+      /// Write a snapshot of a cache and (optionally) a summary store to path
+      static void Write( std::string path, const SharedCache& cache, const SummaryStore * store = nullptr );
+  };
+
+    //--------------------------------------------------------------------------
+    inline bool Snapshot::open( std::string path ){
+
+      close();
+      int fd = ::open( path.c_str(), O_RDONLY );
+      if (fd < 0) return false;
+      struct stat st;
+      if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)){
+        ::close(fd);
+        return false;
+      }
+      mBytes = st.st_size;
+      mMap = mmap( nullptr, mBytes, PROT_READ, MAP_PRIVATE, fd, 0 );
+      ::close(fd);
+      if (mMap == MAP_FAILED) { mMap = nullptr; mBytes = 0; return false; }
+
+      ///Header only: entries are verified when looked up
+      const Header& h = *(const Header*)mMap;
+      size_t expected = sizeof(Header) + h.quotes * sizeof(Entry) + h.records * sizeof(Record);
+      if ( memcmp(h.magic, "CCSNAP", 7) != 0 || h.version != Version ||
+           h.runs != Summary::Runs || h.check != Check(h) || expected != mBytes ){
+        close();
+        return false;
+      }
+      mEntry = (const Entry*)( (const char*)mMap + sizeof(Header) );
+      mRecord = (const Record*)( mEntry + h.quotes );
+      mEntries = h.quotes;
+      mRecords = h.records;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Snapshot::Write( std::string path, const SharedCache& cache, const SummaryStore * store ){
+
+      ///1. Gather and sort entries by key
+      std::vector<Entry> quotes;
+      cache.each( [&]( uint64_t key, const SharedCache::Value& v ){
+        Entry e; e.key = key; e.value = v; e.check = Check(e);
+        quotes.push_back(e);
+      });
+      std::vector<Record> records;
+      if (store){
+        for (auto& i : store->records()){
+          Record r; r.key = i.key; r.summary = i.summary; r.check = Check(r);
+          records.push_back(r);
+        }
+      }
+      std::sort( quotes.begin(), quotes.end(),
+        [](const Entry& a, const Entry& b){ return a.key < b.key; } );
+      std::sort( records.begin(), records.end(),
+        [](const Record& a, const Record& b){ return a.key < b.key; } );
+
+      Header h;
+      memset( &h, 0, sizeof(h) );
+      memcpy( h.magic, "CCSNAP", 7 );
+      h.version = Version;
+      h.runs = Summary::Runs;
+      h.quotes = quotes.size();
+      h.records = records.size();
+      h.check = Check(h);
+
+      ///2. Write to a temporary file of this writer's own, flush it to disk, and
+      /// rename it over the old snapshot (then flush the directory, so the
+      /// rename itself survives a crash)
+      std::string tmp = path + ".XXXXXX";
+      std::vector<char> name( tmp.begin(), tmp.end() );
+      name.push_back(0);
+      int fd = mkstemp( &name[0] );
+      if (fd < 0) throw std::invalid_argument("Error: Cannot Write Snapshot.");
+      auto put = [&]( const void * data, size_t size ){
+        const char * c = (const char*)data;
+        while (size > 0){
+          ssize_t n = ::write( fd, c, size );
+          if (n < 0 && errno == EINTR) continue;
+          if (n <= 0) return false;
+          c += n; size -= n;
+        }
+        return true;
+      };
+      bool ok = fchmod( fd, 0644 ) == 0 && put( &h, sizeof(h) )
+             && (quotes.empty() || put( &quotes[0], quotes.size() * sizeof(Entry) ))
+             && (records.empty() || put( &records[0], records.size() * sizeof(Record) ))
+             && fsync( fd ) == 0;
+      if (::close( fd ) != 0) ok = false;
+      if (!ok){
+        unlink( &name[0] );
+        throw std::invalid_argument("Error: Cannot Write Snapshot.");
+      }
+      if (rename( &name[0], path.c_str() ) != 0){
+        unlink( &name[0] );
+        throw std::invalid_argument("Error: Cannot Replace Snapshot.");
+      }
+      size_t slash = path.rfind( '/' );
+      std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr( 0, slash );
+      int dfd = ::open( dir.c_str(), O_RDONLY );
+      if (dfd >= 0) { fsync( dfd ); ::close( dfd ); }
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_SNAPSHOT_HEADER_INCLUDED */
@@ -0,0 +1,301 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccSummary.hpp
+/// \brief Compact geometry summaries and an append-only store for repricing
+
+#ifndef CC_SUMMARY_HEADER_INCLUDED
+#define CC_SUMMARY_HEADER_INCLUDED
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "ccConstants.hpp"  //< Profile
+
+namespace cc{
+
+  /// \brief Everything needed to price a part without its geometry
+  ///
+  /// Arc length is kept in a few runs of nearby curvature (1/radius), each
+  /// with the range of curvatures it holds and its length-weighted curvature,
+  /// so that any Profile::falloff can be applied without the original arcs.
+  /// A run takes arcs while its range stays within Step; past Runs runs the
+  /// two that make the narrowest range are merged.
+  ///
+  /// An arc's time grows as exp(falloff * curvature), which is convex, so the
+  /// mean curvature of a run would underprice it.  Each run is instead priced
+  /// by the chord of exp over its range through its mean (the
+  /// Edmundson-Madansky bound), which never underprices: for the time t of
+  /// the arcs alone, t <= seconds(f) <= t * exp(|falloff| * spread()), and
+  /// spread() is at most Step unless the arcs need more than Runs runs.
+  struct Summary{
+
+    static constexpr int Runs = 16;                 ///< most runs of curvature
+    static constexpr double Step = 0.25;            ///< widest range of curvature a run takes arcs into (1/inches)
+
+    /// Arcs of nearby curvature
+    struct Run{
+      float lo;                   ///< least curvature
+      float hi;                   ///< greatest curvature
+      float arc;                  ///< arc length (0 if unused)
+      float curvature;            ///< sum of length/radius
+    };
+
+    double width = 0;             ///< unpadded minimum box width
+    double height = 0;            ///< unpadded minimum box height
+    double straight = 0;          ///< total length of straight edges
+    double travel = 0;            ///< rapid travel between loops of the tool path
+    double maxCurvature = 0;      ///< largest curvature of any arc
+    Run run[Runs];                ///< arc length by curvature
+
+    Summary(){
+      memset(run, 0, sizeof(run));
+    }
+
+    /// Accumulate an arc of given length and radius
+    void add( double length, double radius ){
+      double k = 1.0 / radius;
+      if (k > maxCurvature) maxCurvature = k;
+      auto width = []( const Run& r, double lo, double hi ){ return std::max( (double)r.hi, hi ) - std::min( (double)r.lo, lo ); };
+
+      ///1. The run whose range grows least, if it stays within Step, else an empty one
+      int best = -1, empty = -1;
+      double grown = 0;
+      for (int i=0;i<Runs;++i){
+        if (run[i].arc <= 0) { if (empty < 0) empty = i; continue; }
+        double g = width( run[i], k, k ) - (run[i].hi - run[i].lo);
+        if (width( run[i], k, k ) <= Step && (best < 0 || g < grown)) { best = i; grown = g; }
+      }
+
+      ///2. All in use: merge the two runs of narrowest range (or the arc into
+      /// the nearest, if that is narrower still)
+      if (best < 0 && empty < 0){
+        int a = -1, b = -1;
+        double narrow = 0;
+        for (int i=0;i<Runs;++i){
+          double w = width( run[i], k, k );
+          if (a < 0 || w < narrow) { a = i; b = -1; narrow = w; }
+          for (int j=i+1;j<Runs;++j){
+            w = width( run[i], run[j].lo, run[j].hi );
+            if (w < narrow) { a = i; b = j; narrow = w; }
+          }
+        }
+        if (b < 0) best = a;
+        else {
+          run[a].lo = std::min( run[a].lo, run[b].lo );
+          run[a].hi = std::max( run[a].hi, run[b].hi );
+          run[a].arc += run[b].arc;
+          run[a].curvature += run[b].curvature;
+          run[b] = Run();
+          empty = b;
+        }
+      }
+      if (best < 0) { best = empty; run[best].lo = run[best].hi = k; }
+
+      Run& r = run[best];
+      r.lo = std::min( (double)r.lo, k );
+      r.hi = std::max( (double)r.hi, k );
+      r.arc += length;
+      r.curvature += length * k;
+    }
+
+    /// Widest range of curvature of any run
+    double spread() const {
+      double w = 0;
+      for (auto& r : run) if (r.arc > 0) w = std::max( w, (double)r.hi - r.lo );
+      return w;
+    }
+
+    /// Time in seconds under a profile
+    /// (constant velocity model: Profile::acceleration and kerf need the geometry)
+    double seconds( const Profile& f ) const {
+      double weighted = straight;
+      for (auto& r : run){
+        if (r.arc <= 0) continue;
+        double lo = r.lo, hi = r.hi;
+        double mean = std::max( lo, std::min( hi, (double)r.curvature / r.arc ) );
+        if (hi <= lo) { weighted += r.arc * exp( f.falloff * mean ); continue; }
+        // chord of exp(falloff * k) over [lo,hi], at the mean
+        weighted += r.arc * ( (hi - mean) * exp( f.falloff * lo ) + (mean - lo) * exp( f.falloff * hi ) ) / (hi - lo);
+      }
+      return weighted / f.velocity + travel / f.rapid;
+    }
+
+    /// Padded area under a profile
+    double area( const Profile& f ) const {
+      return (width + f.kerf + f.padding) * (height + f.kerf + f.padding);
+    }
+
+    /// Cost in dollars under a profile
+    double cost( const Profile& f ) const {
+      return seconds(f) * f.perSecond + area(f) * f.perUnitArea;
+    }
+  };
+
+  /// \class SummaryStore
+  /// \brief Append-only file of keyed Summary records
+  ///
+  /// Records are written to the end of the file and never modified; a later
+  /// record with the same key supersedes an earlier one.  On open the log is
+  /// replayed into a contiguous in-memory table with a key index, so repricing
+  /// the whole store is a linear pass with no parsing or hulling.
+  class SummaryStore {
+
+    public:
+
+      /// On-disk record
+      struct Record{
+        uint64_t key;         ///< caller supplied part key
+        Summary summary;      ///< geometry summary
+      };
+
+    private:
+
+      /// File header
+      struct Header{
+        char magic[4];
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t runs;
+      };
+
+      static constexpr uint32_t Version = 4;
+
+      /// Path to log file
+      std::string mPath;
+      /// Log file opened for appending
+      std::fstream mFile;
+      /// Latest record of each key
+      std::vector<Record> mRecord;
+      /// Map of key to index in mRecord
+      std::unordered_map<uint64_t,size_t> mIndex;
+
+      static Header Expected(){
+        Header h;
+        memcpy(h.magic, "CCSM", 4);
+        h.version = Version;
+        h.recordSize = sizeof(Record);
+        h.runs = Summary::Runs;
+        return h;
+      }
+
+      /// Insert or supersede in memory
+      void insert( const Record& r ){
+        auto it = mIndex.find(r.key);
+        if (it != mIndex.end()) mRecord[it->second] = r;
+        else {
+          mIndex[r.key] = mRecord.size();
+          mRecord.push_back(r);
+        }
+      }
+
+    public:
+
+      SummaryStore() {}
+
+      /// Construct and open (or create) a store file
+      SummaryStore( std::string path ) { open(path); }
+
+      /// Open (or create) a store file and replay its records
+      void open( std::string path );
+
+      /// Append a summary under key, superseding any earlier record
+      void append( uint64_t key, const Summary& s );
+
+      /// Find the latest summary of key
+      /// \returns pointer to summary or nullptr if not stored
+      const Summary * find( uint64_t key ) const {
+        auto it = mIndex.find(key);
+        return it == mIndex.end() ? nullptr : &mRecord[it->second].summary;
+      }
+
+      /// Number of distinct keys
+      size_t size() const { return mRecord.size(); }
+
+      /// Latest records, in order of first appearance
+      const std::vector<Record>& records() const { return mRecord; }
+
+      /// Cost of every stored part under a profile
+      /// \returns costs in the order of records()
+      std::vector<double> reprice( const Profile& f ) const {
+        std::vector<double> result(mRecord.size());
+        for (size_t i=0;i<mRecord.size();++i) result[i] = mRecord[i].summary.cost(f);
+        return result;
+      }
+  };
+
+    //--------------------------------------------------------------------------
+    inline void SummaryStore::open( std::string path ){
+
+      mPath = path;
+      mRecord.clear();
+      mIndex.clear();
+      if (mFile.is_open()) mFile.close();
+
+      Header expected = Expected();
+
+      ///1. Replay existing log, if any
+      std::ifstream in( path.c_str(), std::ios::binary );
+      if (in.is_open()){
+        Header h;
+        if (in.read( (char*)&h, sizeof(h) )){
+          if (memcmp(&h, &expected, sizeof(h)) != 0)
+            throw std::invalid_argument("Error: Incompatible Summary Store.");
+          Record r;
+          while ( in.read( (char*)&r, sizeof(r) ) ) insert(r);
+        }
+        in.close();
+      }
+
+      ///2. Reopen for appending, writing a header to new files
+      mFile.open( path.c_str(), std::ios::out | std::ios::binary | std::ios::app );
+      if (!mFile.is_open()) throw std::invalid_argument("Error: Cannot Open Summary Store.");
+      mFile.seekp(0, std::ios::end);
+      size_t bytes = mFile.tellp();
+      if (bytes == 0) {
+        mFile.write( (const char*)&expected, sizeof(expected) );
+        mFile.flush();
+      } else if ( bytes < sizeof(Header) || (bytes - sizeof(Header)) % sizeof(Record) != 0 ){
+        // a torn trailing record from an interrupted append would misalign the log
+        throw std::invalid_argument("Error: Truncated Summary Store.");
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    inline void SummaryStore::append( uint64_t key, const Summary& s ){
+      if (!mFile.is_open()) throw std::invalid_argument("Error: Summary Store Not Open.");
+      Record r;
+      r.key = key;
+      r.summary = s;
+      mFile.write( (const char*)&r, sizeof(r) );
+      mFile.flush();
+      insert(r);
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_SUMMARY_HEADER_INCLUDED */
@@ -0,0 +1,207 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccTopology.hpp
+/// \brief Validation of how edges connect vertices, before any geometry is built
+
+#ifndef CC_TOPOLOGY_HEADER_INCLUDED
+#define CC_TOPOLOGY_HEADER_INCLUDED
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "ccGeometry.hpp"   //< Hash
+
+namespace cc{
+
+  /// \brief Flat open-addressing map from sparse IDs to dense indices
+  ///
+  /// Sized once from the number of IDs (at most half full), with linear
+  /// probing over parallel key and index arrays: two allocations in all,
+  /// rather than a tree node per ID.
+  class IdTable {
+
+      std::vector<int> mKey;
+      std::vector<int> mIndex;    ///< -1 marks an empty slot
+      size_t mMask = 0;
+
+      size_t slot( int id ) const { return Hash::Mix( (uint64_t)(uint32_t)id ) & mMask; }
+
+    public:
+
+      /// Empty table with room for n IDs
+      explicit IdTable( size_t n = 0 ){ reserve(n); }
+
+      /// Clear and make room for n IDs
+      void reserve( size_t n ){
+        size_t cap = 16;
+        while (cap < 2*n) cap <<= 1;
+        mKey.assign( cap, 0 );
+        mIndex.assign( cap, -1 );
+        mMask = cap - 1;
+      }
+
+      /// Map id to index
+      /// \returns false (keeping the first index) if id is already present
+      bool insert( int id, int index ){
+        for (size_t s = slot(id);; s = (s + 1) & mMask){
+          if (mIndex[s] < 0) { mKey[s] = id; mIndex[s] = index; return true; }
+          if (mKey[s] == id) return false;
+        }
+      }
+
+      /// Index of id, -1 if absent
+      int find( int id ) const {
+        for (size_t s = slot(id);; s = (s + 1) & mMask){
+          if (mIndex[s] < 0) return -1;
+          if (mKey[s] == id) return mIndex[s];
+        }
+      }
+
+      /// Parse a decimal ID as stream extraction would (leading space and sign,
+      /// digits up to the first other character, saturating at the limits of
+      /// int), without constructing a stream
+      /// \returns false if the ID is out of the range of int
+      static bool Parse( const char * c, int& id ){
+        while (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r') ++c;
+        bool negative = *c == '-';
+        if (*c == '-' || *c == '+') ++c;
+        long long v = 0, limit = negative ? 0x80000000LL : 0x7fffffffLL;
+        bool inRange = true;
+        for (; *c >= '0' && *c <= '9'; ++c){
+          v = v * 10 + (*c - '0');
+          if (v > limit) { v = limit; inRange = false; }
+        }
+        id = (int)( negative ? -v : v );
+        return inRange;
+      }
+
+      static int Parse( const char * c ){ int id; Parse( c, id ); return id; }
+      static int Parse( const std::string& s ){ return Parse( s.c_str() ); }
+  };
+
+  /// \brief Report on the vertex and edge IDs of a part
+  ///
+  /// Vertex IDs are remapped to dense indices in one pass, then every edge is
+  /// checked against them while counting vertex degrees and joining its ends
+  /// in a union-find, so the whole check is linear in the size of the part.
+  /// A part is valid if every edge joins two distinct, existing vertices, but
+  /// for an arc with both ends on one vertex, which is a full circle and
+  /// counts twice on it; it is closed if, in addition, every vertex it uses
+  /// has degree two (it is a set of loops).  Open chains and branches are
+  /// reported but allowed.
+  struct Topology{
+
+    int vertices = 0;     ///< number of vertices
+    int edges = 0;        ///< number of edges
+    int duplicate = 0;    ///< vertex IDs given more than once
+    int missing = 0;      ///< edge ends referring to no vertex
+    int malformed = 0;    ///< edges without exactly two vertices, distinct but for full circles
+    int isolated = 0;     ///< vertices on no edge
+    int dangling = 0;     ///< vertices on one edge (ends of open chains)
+    int branching = 0;    ///< vertices on more than two edges
+    int components = 0;   ///< connected pieces of the part
+    int open = 0;         ///< components that are not closed loops
+    int welded = 0;       ///< vertices merged into others (counted on the welded part)
+    int collapsed = 0;    ///< edges dropped because their ends were merged
+
+    /// Can geometry be built from the IDs?
+    bool valid() const { return !duplicate && !missing && !malformed; }
+
+    /// Is the part made of closed loops only?
+    bool closed() const { return valid() && !dangling && !branching && !open; }
+
+    /// Throw std::invalid_argument naming the first problem, if not valid
+    void check() const {
+      if (duplicate) throw std::invalid_argument("Error: Duplicate Vertex ID.");
+      if (missing) throw std::invalid_argument("Error: Edge References Missing Vertex.");
+      if (malformed) throw std::invalid_argument("Error: Edge Must Join Two Vertices.");
+    }
+
+    /// Validate a part from its vertex IDs and the vertex IDs of each edge,
+    /// leaving the dense index of each vertex ID in `dense`
+    /// \param arcs nonzero for each edge that is a CircularArc (none if empty)
+    static Topology Check( const std::vector<int>& ids, const std::vector< std::vector<int> >& edges, IdTable& dense,
+                           const std::vector<char>& arcs = std::vector<char>() );
+
+    /// Validate a part from its vertex IDs and the vertex IDs of each edge
+    static Topology Check( const std::vector<int>& ids, const std::vector< std::vector<int> >& edges,
+                           const std::vector<char>& arcs = std::vector<char>() ){
+      IdTable dense;
+      return Check( ids, edges, dense, arcs );
+    }
+  };
+
+    //--------------------------------------------------------------------------
+    inline Topology Topology::Check( const std::vector<int>& ids, const std::vector< std::vector<int> >& edges, IdTable& dense,
+                                     const std::vector<char>& arcs ){
+
+      Topology t;
+      int n = ids.size();
+      t.vertices = n;
+      t.edges = edges.size();
+
+      ///1. Dense remap of vertex IDs
+      dense.reserve( n );
+      for (int i=0;i<n;++i) if (!dense.insert( ids[i], i )) t.duplicate++;
+
+      ///2. Degrees and union-find over edge ends
+      std::vector<int> degree( n, 0 ), parent( n );
+      for (int i=0;i<n;++i) parent[i] = i;
+      auto find = [&]( int k ){
+        while (parent[k] != k) k = parent[k] = parent[ parent[k] ];
+        return k;
+      };
+      for (size_t i=0;i<edges.size();++i){
+        auto& e = edges[i];
+        bool arc = i < arcs.size() && arcs[i];
+        int end[2] = { -1, -1 }, found = 0;
+        for (size_t k=0;k<e.size();++k){
+          int d = dense.find( e[k] );
+          if (d < 0) { t.missing++; continue; }
+          if (k < 2) end[k] = d;
+          found++;
+        }
+        // an arc closing on its own vertex is a full circle, a loop on its own
+        if (e.size() != 2 || found != 2 || (end[0] == end[1] && !arc)){
+          if (e.size() != 2 || (found == 2 && end[0] == end[1])) t.malformed++;
+          continue;
+        }
+        degree[ end[0] ]++; degree[ end[1] ]++;
+        parent[ find(end[0]) ] = find(end[1]);
+      }
+
+      ///3. Classify vertices, and mark components holding an end or a branch
+      std::vector<char> root( n, 0 );
+      for (int i=0;i<n;++i){
+        if (degree[i] == 0) { t.isolated++; continue; }
+        int r = find(i);
+        if (!root[r]) { root[r] = 1; t.components++; }
+        if (degree[i] == 2) continue;
+        if (degree[i] == 1) t.dangling++; else t.branching++;
+        if (root[r] == 1) { root[r] = 2; t.open++; }
+      }
+      return t;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_TOPOLOGY_HEADER_INCLUDED */
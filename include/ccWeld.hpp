@@ -0,0 +1,114 @@
+/*
+ * =============================================================================
+ * Copyright (C) 2010  Pablo Colapinto
+ * All rights reserved.
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ * =============================================================================
+*/
+
+/// \file ccWeld.hpp
+/// \brief Merging of near-coincident points on a spatial hash grid
+
+#ifndef CC_WELD_HEADER_INCLUDED
+#define CC_WELD_HEADER_INCLUDED
+
+#include <vector>
+#include <math.h>
+
+#include "ccGeometry.hpp"   //< Vec2, Hash
+
+namespace cc{
+
+  /// \brief Welding of points closer than a tolerance
+  ///
+  /// Points are hashed into square cells as wide as the tolerance, so any
+  /// point within tolerance of another lies in one of the nine cells around
+  /// it.  Each cell keeps a chain of the points kept so far; a point within
+  /// tolerance of a kept one is merged into it (the first one seen), and
+  /// otherwise is kept.  Expected linear time.
+  struct Weld{
+
+    /// Merge points within tolerance
+    /// \param points input points
+    /// \param kept points kept, in order of first appearance
+    /// \returns index into kept of each input point
+    static std::vector<int> Merge( const std::vector<Vec2>& points, double tolerance, std::vector<Vec2>& kept );
+
+    /// Remove points within tolerance of an earlier one, in place
+    static void Unique( std::vector<Vec2>& points, double tolerance ){
+      std::vector<Vec2> kept;
+      Merge( points, tolerance, kept );
+      points.swap( kept );
+    }
+  };
+
+    //--------------------------------------------------------------------------
+    inline std::vector<int> Weld::Merge( const std::vector<Vec2>& points, double tolerance, std::vector<Vec2>& kept ){
+
+      int n = points.size();
+      std::vector<int> result( n );
+      kept.clear();
+      if (tolerance <= 0){
+        kept = points;
+        for (int i=0;i<n;++i) result[i] = i;
+        return result;
+      }
+
+      ///1. Chains of kept points per cell: head of each occupied cell in a flat
+      /// open-addressing table (at most half full), next by kept index
+      size_t cap = 16;
+      while (cap < 2*(size_t)n) cap <<= 1;
+      std::vector<uint64_t> cell( cap );
+      std::vector<int> head( cap, -1 );
+      auto slot = [&]( uint64_t k ){
+        size_t s = k & (cap - 1);
+        while (head[s] >= 0 && cell[s] != k) s = (s + 1) & (cap - 1);
+        return s;
+      };
+      std::vector<int> next;
+      next.reserve( n );
+      kept.reserve( n );
+      auto key = []( long x, long y ){ return Hash::Combine( Hash::Mix( (uint64_t)x ), (uint64_t)y ); };
+      double t2 = tolerance * tolerance;
+
+      ///2. Each point merges into a kept point of the nine cells around it, or is kept
+      for (int i=0;i<n;++i){
+        const Vec2& p = points[i];
+        long cx = (long)floor( p.x / tolerance ), cy = (long)floor( p.y / tolerance );
+        int found = -1;
+        for (long dx=-1; dx<=1 && found<0; ++dx){
+          for (long dy=-1; dy<=1 && found<0; ++dy){
+            for (int k = head[ slot( key( cx+dx, cy+dy ) ) ]; k >= 0; k = next[k]){
+              double ex = kept[k].x - p.x, ey = kept[k].y - p.y;
+              if (ex*ex + ey*ey <= t2) { found = k; break; }
+            }
+          }
+        }
+        if (found < 0){
+          found = kept.size();
+          kept.push_back( p );
+          size_t s = slot( key(cx, cy) );
+          cell[s] = key(cx, cy);
+          next.push_back( head[s] );
+          head[s] = found;
+        }
+        result[i] = found;
+      }
+      return result;
+    }
+
+} //cc::
+
+#endif /* end of include guard: CC_WELD_HEADER_INCLUDED */
@@ -0,0 +1,65 @@
+/// Checks CircularArc::radians() on arcs either side of a half turn and on
+/// full circles, in both directions, and that the cut time of a part follows
+/// the arc's true length
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <sstream>
+
+using namespace cc;
+
+/// Arc about the origin from (1,0) to the unit vector at angle end, on one vertex if whole
+CircularArc Arc( double end, bool clockwise, bool whole = false ){
+  CircularArc a;
+  a.mVec.push_back( std::make_shared<Vec2>( Vec2{ 1, 0 } ) );
+  a.mVec.push_back( whole ? a.mVec[0] : std::make_shared<Vec2>( Vec2{ cos(end), sin(end) } ) );
+  a.mCenter = { 0, 0 };
+  a.bClockwise = clockwise;
+  return a;
+}
+
+int main(){
+
+  ///1. Counterclockwise arcs sweep from 0 to 2PI, clockwise from 0 to -2PI
+  CHECK_NEAR( Arc(  PI/2, false ).radians(),    PI/2, 1e-12 );
+  CHECK_NEAR( Arc( -PI/2, false ).radians(),  3*PI/2, 1e-12 );
+  CHECK_NEAR( Arc( -PI/2, true  ).radians(),   -PI/2, 1e-12 );
+  CHECK_NEAR( Arc(  PI/2, true  ).radians(), -3*PI/2, 1e-12 );
+  CHECK_NEAR( Arc( -PI/4, true  ).length(),     PI/4, 1e-12 );
+  // ends on one vertex are a full circle, distinct vertices that coincide are not
+  CHECK_NEAR( Arc( 0, false, true ).radians(),  2*PI, 1e-12 );
+  CHECK_NEAR( Arc( 0, true,  true ).radians(), -2*PI, 1e-12 );
+  CHECK( Arc( 0, false ).radians() == 0 );
+  CHECK( Arc( 0, true  ).radians() == 0 );
+
+  ///2. A quarter circle cut clockwise takes a quarter circle's time
+  std::stringstream json(
+    "{\"Vertices\":{"
+      "\"1\":{\"Position\":{\"X\":0,\"Y\":0}},"
+      "\"2\":{\"Position\":{\"X\":1,\"Y\":0}},"
+      "\"3\":{\"Position\":{\"X\":0,\"Y\":-1}}},"
+    "\"Edges\":{"
+      "\"1\":{\"Type\":\"LineSegment\",\"Vertices\":[1,2]},"
+      "\"2\":{\"Type\":\"CircularArc\",\"Vertices\":[2,3],\"Center\":{\"X\":0,\"Y\":0},\"ClockwiseFrom\":2},"
+      "\"3\":{\"Type\":\"LineSegment\",\"Vertices\":[3,1]}}}" );
+  Data data;
+  data.read( json );
+  double expected = 2 / Velocity::Max + (PI/2) / Velocity::Radius(1);
+  CHECK_NEAR( data.seconds(), expected, 1e-9 );
+
+  ///3. An arc between two vertices at one point is welded shut into a full
+  ///   circle, and without welding is no more than a point
+  for (bool clockwise : { false, true }){
+    test::Part part;
+    int a = part.vertex( { 1, 0 } ), b = part.vertex( { 1, 0 } );
+    part.arc( a, b, { 0, 0 }, clockwise );
+    Data shut = test::Read( part ), open = test::Read( part, 20, 0 );
+    CHECK( shut.topology().closed() && shut.shape().kind == Shape::Circle );
+    CHECK_NEAR( shut.seconds(), 2*PI / Velocity::Radius(1), 1e-9 );
+    CHECK( open.topology().welded == 0 && !open.topology().closed() );
+    CHECK( open.seconds() == 0 );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,71 @@
+/// Checks the shared quote cache: values written are found again, and a
+/// segment whose header was left half written by a process that died is
+/// taken over instead of refused
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <sys/wait.h>
+
+using namespace cc;
+
+/// Layout of the segment header written by SharedCache
+struct Header{
+  char magic[8];
+  uint32_t version;
+  uint32_t mask;
+  std::atomic<uint32_t> state;
+  std::atomic<int32_t> owner;
+};
+
+/// Leave name with a header claimed by owner but never finished
+void Abandon( std::string name, int32_t owner ){
+  int fd = shm_open( name.c_str(), O_CREAT | O_RDWR, 0600 );
+  if (ftruncate( fd, sizeof(Header) ) != 0) return;
+  Header * h = (Header*)mmap( nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close(fd);
+  h->owner = owner;
+  h->state = 1;
+  munmap( h, sizeof(Header) );
+}
+
+bool Opens( std::string name ){
+  try { SharedCache cache( name, 64 ); return true; }
+  catch (std::invalid_argument&) { return false; }
+}
+
+int main(){
+
+  std::string name = "/cctest" + std::to_string( getpid() );
+  SharedCache::Remove( name );
+
+  ///1. Values written by one mapping are found through another
+  {
+    SharedCache a( name, 64 ), b( name, 64 );
+    CHECK( a.insert( 42, { 1, 2, 3, 99 } ) );
+    SharedCache::Value v;
+    CHECK( b.find( 42, v ) && v.seconds == 1 && v.area == 2 && v.cost == 3 && v.check == 99 );
+    CHECK( !b.find( 43, v ) );
+  }
+  SharedCache::Remove( name );
+
+  ///2. A header claimed by a process that died is written by the next to open
+  pid_t child = fork();
+  if (child == 0) _exit(0);
+  waitpid( child, nullptr, 0 );
+  Abandon( name, child );
+  {
+    CHECK( Opens( name ) );
+    SharedCache cache( name, 64 );
+    SharedCache::Value v;
+    CHECK( cache.insert( 7, { 4, 5, 6 } ) && cache.find( 7, v ) && v.cost == 6 );
+  }
+  SharedCache::Remove( name );
+
+  ///3. A header claimed by a live process that never finishes is still refused
+  Abandon( name, getpid() );
+  CHECK( !Opens( name ) );
+  SharedCache::Remove( name );
+
+  return test::Report();
+}
@@ -0,0 +1,123 @@
+/// \file check.hpp
+/// \brief Minimal checks shared by the programs in test/
+///
+/// Each failed check prints its expression and line; Report() prints a
+/// tally and returns the number of failures, so main can return it and
+/// ctest sees a non-zero exit.  Part builds the JSON of files/Schema.json
+/// and Read loads it, for tests that draw their own parts.
+
+#ifndef CC_TEST_CHECK_INCLUDED
+#define CC_TEST_CHECK_INCLUDED
+
+#include "cc.hpp"
+
+#include <cstdio>
+#include <math.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace cc{ namespace test{
+
+  inline int& Checks(){ static int n = 0; return n; }
+  inline int& Failures(){ static int n = 0; return n; }
+
+  inline void Check( bool ok, const char * what, const char * file, int line ){
+    Checks()++;
+    if (ok) return;
+    Failures()++;
+    printf("FAILED %s:%d: %s\n", file, line, what);
+  }
+
+  /// Is a within rel of b, relative to the larger magnitude (or absolutely, below 1)?
+  inline bool Near( double a, double b, double rel ){
+    double m = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return fabs(a - b) <= rel * (m > 1 ? m : 1);
+  }
+
+  inline int Report(){
+    printf("%d checks, %d failed\n", Checks(), Failures());
+    return Failures();
+  }
+
+  /// Part drawn vertex by vertex and edge by edge, written as files/Schema.json lays it out
+  struct Part {
+
+    struct Piece { int a, b; bool bArc; Vec2 center; bool bClockwise; };
+
+    std::vector<Vec2> vertices;
+    std::vector<Piece> edges;
+
+    /// Add a vertex at v, returning its ID (counting from 1)
+    int vertex( Vec2 v ){ vertices.push_back( v ); return vertices.size(); }
+
+    /// Line segment from vertex a to vertex b
+    Part& line( int a, int b ){ edges.push_back( { a, b, false, Vec2(), false } ); return *this; }
+
+    /// Circular arc from vertex a to vertex b about center (a full circle if a is b)
+    Part& arc( int a, int b, Vec2 center, bool clockwise = false ){
+      edges.push_back( { a, b, true, center, clockwise } );
+      return *this;
+    }
+
+    /// Closed loop of line segments through p
+    Part& polygon( const std::vector<Vec2>& p ){
+      int first = vertices.size() + 1, n = p.size();
+      for (auto& v : p) vertex( v );
+      for (int i=0;i<n;++i) line( first + i, first + (i+1)%n );
+      return *this;
+    }
+
+    /// Rectangle of w by h from the origin, its corners rounded counterclockwise by radii r[4]
+    Part& rounded( double w, double h, const double r[4] ){
+      // corner centers, and the points where each corner's arc meets the sides
+      Vec2 c[4] = { { w-r[0], r[0] }, { w-r[1], h-r[1] }, { r[2], h-r[2] }, { r[3], r[3] } };
+      Vec2 p[8] = { { w-r[0], 0 }, { w, r[0] }, { w, h-r[1] }, { w-r[1], h },
+                    { r[2], h }, { 0, h-r[2] }, { 0, r[3] }, { r[3], 0 } };
+      int first = vertices.size() + 1;
+      for (auto& v : p) vertex( v );
+      for (int i=0;i<4;++i) arc( first + 2*i, first + 2*i + 1, c[i] ).line( first + 2*i + 1, first + (2*i + 2) % 8 );
+      return *this;
+    }
+
+    std::string json() const {
+      std::stringstream s;
+      s.precision(17);
+      s << "{\"Vertices\":{";
+      for (size_t i=0;i<vertices.size();++i)
+        s << (i ? "," : "") << "\"" << i+1 << "\":{\"Position\":{\"X\":" << vertices[i].x << ",\"Y\":" << vertices[i].y << "}}";
+      s << "},\"Edges\":{";
+      for (size_t i=0;i<edges.size();++i){
+        const Piece& e = edges[i];
+        s << (i ? "," : "") << "\"" << i+1 << "\":{\"Type\":\"" << (e.bArc ? "CircularArc" : "LineSegment")
+          << "\",\"Vertices\":[" << e.a << "," << e.b << "]";
+        // an arc runs clockwise from the vertex named, so a counterclockwise full circle names none of its own
+        if (e.bArc) s << ",\"Center\":{\"X\":" << e.center.x << ",\"Y\":" << e.center.y << "},\"ClockwiseFrom\":"
+                      << (e.bClockwise ? e.a : (e.a == e.b ? 0 : e.b));
+        s << "}";
+      }
+      s << "}}";
+      return s.str();
+    }
+  };
+
+  /// Data read from json at resolution, welding vertices within weld
+  inline Data Read( const std::string& json, int resolution = 20, double weld = 1e-6 ){
+    std::stringstream in( json );
+    Data data;
+    data.resolution( resolution );
+    data.weld( weld );
+    data.read( in );
+    return data;
+  }
+
+  inline Data Read( const Part& part, int resolution = 20, double weld = 1e-6 ){
+    return Read( part.json(), resolution, weld );
+  }
+
+}} //cc::test::
+
+#define CHECK(x) cc::test::Check( (x), #x, __FILE__, __LINE__ )
+#define CHECK_NEAR(a,b,rel) cc::test::Check( cc::test::Near( (a), (b), (rel) ), #a " ~ " #b, __FILE__, __LINE__ )
+
+#endif /* end of include guard: CC_TEST_CHECK_INCLUDED */
@@ -0,0 +1,93 @@
+/// Checks that CommonLine counts the length shared by collinear edges of
+/// different parts once per extra pass: edges either way along lines at
+/// any angle (including either side of 0 and PI, where the offset of the
+/// line flips sign), partial and three-way overlaps, and nothing for edges
+/// of one part, edges apart by more than the tolerance, or edges end to end
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Edge of part from s0 to s1 along the line at angle t, offset o from the origin
+void Add( CommonLine& c, double t, double o, double s0, double s1, int part ){
+  Vec2 d = { cos(t), sin(t) }, n = { -sin(t), cos(t) };
+  c.add( Vec2{ n.x * o + d.x * s0, n.y * o + d.y * s0 }, Vec2{ n.x * o + d.x * s1, n.y * o + d.y * s1 }, part );
+}
+
+int main(){
+
+  std::mt19937 rng( 36 );
+  std::uniform_real_distribution<double> u( -1, 1 ), turn( 0, 2*PI );
+
+  const double tol = .005;
+  std::vector<double> angles = { 0, 1e-12, -1e-12, 1e-4, -1e-4, PI, PI - 1e-12, PI + 1e-12, PI/2, -PI/2 };
+  for (int k=0;k<20;++k) angles.push_back( turn(rng) );
+
+  for (double t : angles){
+    // lines through the origin, where the offset is near zero either side, and far from it
+    for (double o : { 0.0, tol / 4, -tol / 4, 7.5, -7.5 }){
+      // the second edge is turned a little, and moved a little off the line, within tolerance
+      double dt = 1e-5 * u(rng), dn = tol / 3 * u(rng);
+
+      ///1. Neighbours cut the shared edge in opposite directions: counted once
+      {
+        CommonLine c;
+        Add( c, t, o, 0, 10, 1 );
+        Add( c, t + PI + dt, -(o + dn), -10, 0, 2 );
+        CHECK_NEAR( c.shared(), 10, 1e-3 );
+      }
+
+      ///2. Partial overlap: the overlap only, either way round
+      {
+        CommonLine c;
+        Add( c, t, o, 0, 10, 1 );
+        Add( c, t + dt, o + dn, 6, 14, 2 );
+        CHECK_NEAR( c.shared(), 4, 1e-3 );
+        CommonLine r;
+        Add( r, t + dt, o + dn, 14, 6, 2 );
+        Add( r, t, o, 10, 0, 1 );
+        CHECK_NEAR( r.shared(), 4, 1e-3 );
+      }
+
+      ///3. Three parts: depth less one over each stretch, [2,4] once and [4,10] twice
+      {
+        CommonLine c;
+        Add( c, t, o, 0, 10, 1 );
+        Add( c, t + PI, -o, -10, -2, 2 );
+        Add( c, t + dt, o + dn, 4, 12, 3 );
+        CHECK_NEAR( c.shared(), 2 + 2 * 6, 1e-3 );
+      }
+
+      ///4. Nothing shared: one part, off the line, end to end
+      {
+        CommonLine c;
+        Add( c, t, o, 0, 10, 1 );
+        Add( c, t, o, 5, 15, 1 );
+        Add( c, t, o + 3 * tol, 0, 10, 2 );
+        Add( c, t, o, 15, 25, 3 );
+        CHECK( c.shared() == 0 );
+      }
+    }
+  }
+
+  ///5. Many squares edge to edge in a grid at any turn: every inner edge once
+  for (int k=0;k<10;++k){
+    double t = k < 2 ? k * PI / 2 + 1e-12 : turn(rng);
+    Vec2 d = { cos(t), sin(t) }, n = { -sin(t), cos(t) };
+    auto at = [&]( double x, double y ){ return Vec2{ d.x * x + n.x * y, d.y * x + n.y * y }; };
+    CommonLine c;
+    int rows = 6, cols = 8;
+    for (int i=0;i<cols;++i){
+      for (int j=0;j<rows;++j){
+        Vec2 p[4] = { at( i, j ), at( i+1, j ), at( i+1, j+1 ), at( i, j+1 ) };
+        for (int e=0;e<4;++e) c.add( p[e], p[(e+1)%4], i * rows + j );
+      }
+    }
+    CHECK_NEAR( c.shared(), (cols - 1) * rows + (rows - 1) * cols, 1e-6 );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,149 @@
+/// Checks that Data::fit replaces polylines sampled from known arcs, and
+/// wavy and random polylines, by pieces within the tolerance of them both
+/// ways, that the box area moves no more than the tolerance allows, that
+/// fitted circles are timed as circles within the tolerance, and that
+/// Biarc::Polyline keeps every point of few, uneven segments within it
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Distance from x to the closed polyline p
+double ToPolyline( const std::vector<Vec2>& p, const Vec2& x ){
+  double best = 1e300;
+  for (size_t i=0;i<p.size();++i){
+    Piece s; s.a = p[i]; s.b = p[(i+1)%p.size()];
+    best = std::min( best, Biarc::Distance( s, x ) );
+  }
+  return best;
+}
+
+/// Hausdorff distance between the closed polyline p and pieces, sampled finely along both
+double Hausdorff( const std::vector<Vec2>& p, const std::vector<Piece>& pieces ){
+  double worst = 0;
+  for (size_t i=0;i<p.size();++i){
+    Vec2 u = p[i], v = p[(i+1)%p.size()];
+    for (int k=0;k<=8;++k){
+      Vec2 x = u + Vec2{ (v.x - u.x) * k / 8, (v.y - u.y) * k / 8 };
+      double best = 1e300;
+      for (auto& q : pieces) best = std::min( best, Biarc::Distance( q, x ) );
+      worst = std::max( worst, best );
+    }
+  }
+  for (auto& q : pieces){
+    double start = q.arc() ? Vec2::Theta( q.a - q.center ) : 0, r = q.radius();
+    for (int k=0;k<=32;++k){
+      Vec2 x = q.arc() ? Vec2::Construct( q.center, start + q.sweep * k / 32, r )
+                       : q.a + Vec2{ (q.b.x - q.a.x) * k / 32, (q.b.y - q.a.y) * k / 32 };
+      worst = std::max( worst, ToPolyline( p, x ) );
+    }
+  }
+  return worst;
+}
+
+/// Fit p within tolerance, checking the pieces and the box area against p
+/// \returns the fitted part
+Data Check( const std::vector<Vec2>& p, double tolerance, bool fewer ){
+  test::Part part;
+  part.polygon( p );
+  const int res = 256;
+  Data data = test::Read( part, res ), fitted = test::Read( part, res );
+  int removed = fitted.fit( tolerance );
+  if (fewer) CHECK( removed > 0 );
+  auto loops = fitted.loops();
+  CHECK( loops.size() == 1 && loops[0].bClosed );
+  auto pieces = fitted.pieces( loops[0] );
+  CHECK( Hausdorff( p, pieces ) <= tolerance * (1 + 1e-9) );
+  // each box, grown by the tolerance on every side, holds the other part
+  // (and so a box of it at least as small), but for the sagitta of the steps of arcs
+  double sagitta = 0;
+  for (auto& q : pieces) if (q.arc()) sagitta = std::max( sagitta, q.radius() * (1 - cos( q.sweep / (2 * res) )) );
+  Hull::Box a = data.box(), b = fitted.box();
+  double pad = Material::Padding, t = 2 * (tolerance + sagitta) + 1e-12;
+  CHECK( fitted.area() <= (a.width + t + pad) * (a.height + t + pad) );
+  CHECK( data.area() <= (b.width + t + pad) * (b.height + t + pad) );
+  return fitted;
+}
+
+int main(){
+
+  std::mt19937 rng( 45 );
+  std::uniform_real_distribution<double> u( -1, 1 ), radius( .5, 5 ), turn( 0, 2*PI );
+
+  ///1. Circles and rounded rectangles sampled finely: far fewer pieces, and
+  ///   circles refitted on circles within the tolerance, timed as those
+  for (int k=0;k<10;++k){
+    double r = radius(rng), t = turn(rng), tolerance = r * 1e-3;
+    Vec2 c = { 10 * u(rng), 10 * u(rng) };
+    std::vector<Vec2> p;
+    for (int i=0;i<400;++i) p.push_back( Vec2::Construct( c, t + 2*PI*i/400, r ) );
+    Data fitted = Check( p, tolerance, true );
+    // pieces within the tolerance of chords within the sagitta of the circle:
+    // arcs on circles within that of it, the loop no longer than the circle
+    // so grown (a convex loop in another is the shorter), and timed so
+    double near = tolerance + r * (1 - cos( PI / 400 )), arcs = 0, lines = 0;
+    for (auto& q : fitted.pieces( fitted.loops()[0] )){
+      if (!q.arc()) { lines += q.length(); continue; }
+      arcs += q.length();
+      CHECK( fabs( q.radius() - r ) <= near && (q.center - c).norm() <= near );
+    }
+    CHECK( arcs + lines <= 2*PI * (r + near) );
+    double slow = lines / Velocity::Max + arcs / Velocity::Radius( r - near );
+    double fast = lines / Velocity::Max + arcs / Velocity::Radius( r + near );
+    CHECK( fitted.seconds() >= fast * (1 - 1e-12) && fitted.seconds() <= slow * (1 + 1e-12) );
+  }
+  for (int k=0;k<10;++k){
+    double w = 2 + 8 * (u(rng) + 1), h = 2 + 8 * (u(rng) + 1), r = radius(rng) / 5, tolerance = 1e-3;
+    Vec2 c[4] = { { w-r, r }, { w-r, h-r }, { r, h-r }, { r, r } };
+    std::vector<Vec2> p;
+    for (int q=0;q<4;++q)
+      for (int i=0;i<=32;++i) p.push_back( Vec2::Construct( c[q], PI/2 * (q - 1) + PI/2 * i / 32, r ) );
+    Check( p, tolerance, true );
+  }
+
+  ///2. Wavy loops and random polygons: within tolerance, whatever is kept
+  for (int k=0;k<10;++k){
+    double a = .05 + .2 * (u(rng) + 1), tolerance = k % 2 ? 1e-2 : 1e-4;
+    int waves = 3 + k;
+    std::vector<Vec2> p;
+    for (int i=0;i<300;++i){
+      double t = 2*PI*i/300;
+      p.push_back( Vec2::Construct( t, 1 + a * sin( waves * t ) ) );
+    }
+    Check( p, tolerance, true );
+  }
+  for (int k=0;k<10;++k){
+    std::vector<Vec2> p;
+    for (int i=0;i<60;++i) p.push_back( Vec2::Construct( 2*PI*i/60, 1 + .05 * u(rng) ) );
+    Check( p, .02, false );
+  }
+
+  ///3. Few, uneven segments near a circle, where a biarc can stray from a
+  ///   segment between its ends and its midpoint: every point within tolerance
+  for (int k=0;k<300;++k){
+    std::vector<Vec2> p;
+    int n = 4 + k % 8;
+    double a = 0, r = 2 + u(rng) * 1.5, tolerance = .025 + u(rng) * .024;
+    for (int i=0;i<n;++i){
+      a += .25 + .2 * u(rng);
+      p.push_back( Vec2::Construct( a, r * (1 + .01 * u(rng)) ) );
+    }
+    std::vector<int> start;
+    auto pieces = Biarc::Polyline( p, false, tolerance, start );
+    double worst = 0;
+    for (int i=0;i+1<n;++i){
+      for (int j=0;j<=64;++j){
+        Vec2 x = p[i] + Vec2{ (p[i+1].x - p[i].x) * j / 64, (p[i+1].y - p[i].y) * j / 64 };
+        double best = 1e300;
+        for (auto& q : pieces) best = std::min( best, Biarc::Distance( q, x ) );
+        worst = std::max( worst, best );
+      }
+    }
+    CHECK( worst <= tolerance * (1 + 1e-9) );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,74 @@
+/// Checks IdTable against std::map on sparse and negative IDs, that
+/// IdTable::Parse reads IDs as stream extraction does (saturating on
+/// overflow), and that Data rejects IDs out of the range of int
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <map>
+#include <random>
+#include <sstream>
+
+using namespace cc;
+
+int main(){
+
+  ///1. Sparse IDs, negatives and repeats: first index kept, absent IDs -1
+  std::mt19937 rng( 42 );
+  std::uniform_int_distribution<int> id( -1000000, 1000000 );
+  IdTable table( 1000 );
+  std::map<int,int> reference;
+  for (int i=0;i<1000;++i){
+    int k = i % 10 == 0 ? i / 10 : id(rng);
+    bool fresh = reference.insert( { k, i } ).second;
+    CHECK( table.insert( k, i ) == fresh );
+  }
+  for (auto& r : reference) CHECK( table.find( r.first ) == r.second );
+  int absent = 0;
+  for (int i=0;i<1000;++i){
+    int k = id(rng);
+    if (reference.count(k)) continue;
+    absent++;
+    CHECK( table.find(k) == -1 );
+  }
+  CHECK( absent > 0 );
+
+  ///2. reserve() empties the table
+  table.reserve( 4 );
+  CHECK( table.find( reference.begin()->first ) == -1 );
+  CHECK( table.insert( 5, 0 ) && table.find( 5 ) == 0 );
+
+  ///3. Parse agrees with operator>> on leading space, signs, trailing characters
+  ///   and overflow (which saturates), and reports IDs out of range
+  for (const char * s : { "0", "17", " 42", "\t-7", "+3", "12abc", "-", "", "abc", "2147483647", "-2147483647", "0012",
+                          "-2147483648", "2147483648", "-2147483649", "99999999999", "4294967297", "-4294967297",
+                          "123456789012345678901234567890" }){
+    std::stringstream in( s );
+    int expected = 0;
+    in >> expected;
+    CHECK( IdTable::Parse( s ) == expected );
+    CHECK( IdTable::Parse( std::string( s ) ) == expected );
+  }
+  for (const char * s : { "2147483647", "-2147483648", "00000000000000000001" }){
+    int id;
+    CHECK( IdTable::Parse( s, id ) );
+  }
+  for (const char * s : { "2147483648", "-2147483649", "99999999999", "4294967297" }){
+    int id;
+    CHECK( !IdTable::Parse( s, id ) );
+  }
+
+  ///4. A part with a vertex ID past the range of int is rejected, not aliased
+  for (const char * name : { "4294967297", "2147483648", "-2147483649" }){
+    std::string json = std::string( "{\"Vertices\":{"
+      "\"1\":{\"Position\":{\"X\":0,\"Y\":0}},"
+      "\"" ) + name + "\":{\"Position\":{\"X\":1,\"Y\":0}}},"
+      "\"Edges\":{\"1\":{\"Type\":\"LineSegment\",\"Vertices\":[1,1]}}}";
+    bool rejected = false;
+    try { test::Read( json ); }
+    catch (std::invalid_argument& e) { rejected = std::string( e.what() ) == "Error: ID Out Of Range."; }
+    CHECK( rejected );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,82 @@
+/// Checks on large random clouds (discs, rings, turned ellipses, squares,
+/// clusters, lattices and needles) that the exact minimum box lies within
+/// the bounds of Kernel::Box and of Kernel::Bounds, and within those of
+/// Data::estimate on parts of many vertices
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Area of the exact minimum box of a cloud
+double Exact( std::vector<Vec2> cloud ){
+  auto hull = Hull::Convex( cloud );
+  Hull::Box b = Hull::MinimumBox( hull );
+  return b.width * b.height;
+}
+
+int main(){
+
+  std::mt19937 rng( 46 );
+  std::uniform_real_distribution<double> u( -1, 1 ), turn( 0, 2*PI );
+  std::normal_distribution<double> g( 0, 1 );
+
+  ///1. Every kind of cloud, at several sizes and kernel resolutions
+  for (int k=0;k<35;++k){
+    int n = k % 2 ? 50000 : 10000 + rng() % 1000;
+    double t = turn(rng), sx = 1 + 9 * (u(rng) + 1), sy = .01 + (u(rng) + 1);
+    Vec2 o = { 100 * u(rng), 100 * u(rng) };
+    std::vector<Vec2> cloud;
+    for (int i=0;i<n;++i){
+      Vec2 p;
+      switch (k % 7){
+        case 0: { double r = sqrt( (u(rng) + 1) / 2 ), a = turn(rng); p = { r * cos(a), r * sin(a) }; break; }
+        case 1: { double a = turn(rng); p = { cos(a), sin(a) }; break; }                     // all on the hull
+        case 2: { double r = sqrt( (u(rng) + 1) / 2 ), a = turn(rng); p = { sx * r * cos(a), sy * r * sin(a) }; break; }
+        case 3: p = { sx * u(rng), sx * u(rng) }; break;
+        case 4: p = { g(rng) + (i % 3) * 4, g(rng) * (1 + i % 2) }; break;
+        case 5: p = { (double)(rng() % 50), (double)(rng() % 20) }; break;                  // repeated, collinear
+        default: p = { sx * u(rng), 1e-6 * u(rng) }; break;                                  // a needle
+      }
+      cloud.push_back( o + Vec2{ p.x * cos(t) - p.y * sin(t), p.x * sin(t) + p.y * cos(t) } );
+    }
+    std::vector<Vec2> scratch = cloud;
+    Hull::Box b = Hull::MinimumBox( Hull::Convex( scratch ) );
+    double exact = b.width * b.height;
+    for (double epsilon : { .1, .01, .001 }){
+      Kernel::Estimate e = Kernel::Box( cloud, Kernel::Cells( epsilon ) );
+      CHECK( e.area <= exact * (1 + 1e-9) && exact <= e.upper * (1 + 1e-9) );
+      CHECK( e.points <= (size_t)(4 * Kernel::Cells( epsilon )) || e.points == cloud.size() );
+    }
+    double lower, upper, diameter;
+    Kernel::Bounds( cloud, lower, upper, diameter );
+    CHECK( lower <= exact * (1 + 1e-9) && exact <= upper * (1 + 1e-9) );
+    CHECK( std::max( b.width, b.height ) <= diameter * (1 + 1e-9) );
+  }
+
+  ///2. Parts of thousands of vertices and arcs: estimate() of what discretize() gives
+  for (int k=0;k<4;++k){
+    int n = 2000 + 4000 * k;
+    std::vector<Vec2> p;
+    double sx = 1 + (u(rng) + 1), t = turn(rng);
+    for (int i=0;i<n;++i){
+      double a = 2*PI * i / n, r = 1 + .1 * sin( 7 * a ) + .01 * u(rng);
+      p.push_back( { sx * r * cos(a + t), r * sin(a + t) } );
+    }
+    test::Part part;
+    part.polygon( p );
+    double c[4] = { .2, .3, .1, .4 };
+    part.rounded( 3, 2, c );
+    Data data = test::Read( part, 64 );
+    double exact = Exact( data.discretize() );
+    for (double epsilon : { .05, .01 }){
+      Kernel::Estimate e = data.estimate( epsilon );
+      CHECK( e.area <= exact * (1 + 1e-9) && exact <= e.upper * (1 + 1e-9) );
+      CHECK( e.error >= 0 );
+    }
+  }
+
+  return test::Report();
+}
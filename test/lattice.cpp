@@ -0,0 +1,85 @@
+/// Checks Lattice against known densest double-lattice packings of regular
+/// polygons, and that the copies of random convex parts never overlap
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+std::vector<Vec2> Regular( int n, double radius = 1 ){
+  std::vector<Vec2> p;
+  for (int i=0;i<n;++i) p.push_back( { radius * cos( 2*PI*i/n ), radius * sin( 2*PI*i/n ) } );
+  return p;
+}
+
+/// Do convex loops a and b overlap by more than eps? (separating axes)
+bool Overlap( const std::vector<Vec2>& a, const std::vector<Vec2>& b, double eps ){
+  for (auto* p : { &a, &b }){
+    int n = p->size();
+    for (int i=0;i<n;++i){
+      Vec2 e = (*p)[(i+1)%n] - (*p)[i];
+      Vec2 axis = Vec2{ e.y, -e.x }.unit();
+      double a0 = 1e300, a1 = -1e300, b0 = 1e300, b1 = -1e300;
+      for (auto& v : a) { a0 = std::min( a0, Vec2::Dot( axis, v ) ); a1 = std::max( a1, Vec2::Dot( axis, v ) ); }
+      for (auto& v : b) { b0 = std::min( b0, Vec2::Dot( axis, v ) ); b1 = std::max( b1, Vec2::Dot( axis, v ) ); }
+      if (a1 <= b0 + eps || b1 <= a0 + eps) return false;
+    }
+  }
+  return true;
+}
+
+/// Copies of the lattice around the origin overlapping K or -K+t
+int Overlaps( const Lattice& lattice ){
+  auto& k = lattice.outline();
+  std::vector< std::vector<Vec2> > copies;
+  for (int i=-3;i<=3;++i){
+    for (int j=-3;j<=3;++j){
+      Vec2 o = { i * lattice.a().x + j * lattice.b().x, i * lattice.a().y + j * lattice.b().y };
+      std::vector<Vec2> c0, c1;
+      for (auto& v : k) { c0.push_back( v + o ); c1.push_back( lattice.t() - v + o ); }
+      copies.push_back( c0 );
+      copies.push_back( c1 );
+    }
+  }
+  // copies[48] and [49] are K and -K+t themselves
+  int count = 0;
+  for (int c=0;c<(int)copies.size();++c){
+    if (c != 48 && Overlap( copies[48], copies[c], 1e-7 )) count++;
+    if (c != 49 && Overlap( copies[49], copies[c], 1e-7 )) count++;
+  }
+  return count;
+}
+
+int main(){
+
+  ///1. Tiles fill the plane, the pentagon reaches (5 - sqrt 5)/3, the octagon
+  /// its lattice packing density, and a 64-gon about that of circles
+  CHECK_NEAR( Lattice( Regular(3), 0 ).density(), 1, 1e-9 );
+  CHECK_NEAR( Lattice( Regular(4), 0 ).density(), 1, 1e-9 );
+  CHECK_NEAR( Lattice( Regular(6), 0 ).density(), 1, 1e-9 );
+  CHECK_NEAR( Lattice( Regular(5), 0 ).density(), (5 - sqrt(5.0)) / 3, 1e-9 );
+  CHECK_NEAR( Lattice( Regular(8), 0 ).density(), (4 + 4*sqrt(2.0)) / (5 + 4*sqrt(2.0)), 1e-9 );
+  CHECK_NEAR( Lattice( Regular(64), 0 ).density(), PI / sqrt(12.0), 1e-3 );
+
+  ///2. A unit square with no spacing packs 100 to a 10 x 10 sheet
+  std::vector<Vec2> square = { {0,0}, {1,0}, {1,1}, {0,1} };
+  CHECK( Lattice( square, 0 ).perSheet( 10, 10 ) == 100 );
+
+  ///3. Random hulls: copies clear each other, and stay within the density of a tiling
+  std::mt19937 rng( 35 );
+  std::uniform_real_distribution<double> u( -1, 1 );
+  for (int k=0;k<100;++k){
+    std::vector<Vec2> points;
+    int n = 3 + rng() % 40;
+    for (int i=0;i<n;++i) points.push_back( { u(rng) * (1 + k%3), u(rng) } );
+    auto hull = Hull::Convex( points );
+    if (hull.size() < 3) continue;
+    Lattice lattice( hull, .05 );
+    CHECK( Overlaps( lattice ) == 0 );
+    CHECK( lattice.density() > 0 && lattice.density() <= 1 + 1e-9 );
+  }
+
+  return test::Report();
+}
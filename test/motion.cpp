@@ -0,0 +1,103 @@
+/// Checks Motion against closed forms: a straight move that reaches its
+/// cruise speed and one that does not, corners of ninety degrees with long
+/// and short moves, straight on and reversed junctions, and a square cut
+/// with limited acceleration through Data::seconds
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Time of a move of length L from v0 to v1 cruising at v, with acceleration a (reaching v)
+double Trapezoid( double L, double v, double v0, double v1, double a ){
+  double up = (v*v - v0*v0) / (2*a), down = (v*v - v1*v1) / (2*a);
+  return (v - v0) / a + (v - v1) / a + (L - up - down) / v;
+}
+
+int main(){
+
+  std::mt19937 rng( 38 );
+  std::uniform_real_distribution<double> u( .1, 1 );
+
+  Vec2 x = { 1, 0 }, y = { 0, 1 };
+
+  for (int k=0;k<50;++k){
+    double a = 10 * u(rng), v = 5 * u(rng), d = .01 * u(rng);
+
+    ///1. One move from rest to rest: L / v + v / a if long enough to cruise
+    ///   (v^2 / a), else a triangle of 2 sqrt( L / a )
+    {
+      double L = v*v / a * (1 + u(rng));
+      Motion m( a, d );
+      m.add( L, v, x, x );
+      CHECK_NEAR( m.seconds(), L / v + v / a, 1e-12 );
+      double l = v*v / a * u(rng) * .99;
+      Motion n( a, d );
+      n.add( l, v, x, x );
+      CHECK_NEAR( n.seconds(), 2 * sqrt( l / a ), 1e-12 );
+    }
+
+    ///2. A ninety degree corner between long moves: through it at the
+    ///   junction speed sqrt( a d s / (1 - s) ), s = sin 45
+    {
+      double s = sqrt( .5 ), vj = std::min( v, sqrt( a * d * s / (1 - s) ) );
+      double L = v*v / a * (1 + u(rng));
+      Motion m( a, d );
+      CHECK_NEAR( m.junction( x, y ), sqrt( a * d * s / (1 - s) ), 1e-12 );
+      m.add( L, v, x, x );
+      m.add( L, v, y, y );
+      CHECK_NEAR( m.seconds(), 2 * Trapezoid( L, v, 0, vj, a ), 1e-12 );
+    }
+
+    ///3. The same corner between moves too short to reach the junction
+    ///   speed: accelerate all the way in and brake all the way out
+    {
+      double s = sqrt( .5 ), vj = sqrt( a * d * s / (1 - s) );
+      double l = std::min( vj, v ) * std::min( vj, v ) / (2*a) * u(rng);
+      Motion m( a, d );
+      m.add( l, v, x, x );
+      m.add( l, v, y, y );
+      CHECK_NEAR( m.seconds(), 2 * sqrt( 2 * l / a ), 1e-12 );
+    }
+
+    ///4. Straight on, two moves are one; reversed, or after a stop, two apart
+    {
+      double L = v*v / a * (1 + u(rng));
+      Motion on( a, d ), back( a, d ), stop( a, d );
+      on.add( L, v, x, x );
+      on.add( L, v, x, x );
+      CHECK_NEAR( on.seconds(), 2 * L / v + v / a, 1e-12 );
+      back.add( L, v, x, x );
+      back.add( L, v, Vec2{ -1, 0 }, Vec2{ -1, 0 } );
+      stop.add( L, v, x, x );
+      stop.stop();
+      stop.add( L, v, x, x );
+      CHECK_NEAR( back.seconds(), 2 * (L / v + v / a), 1e-12 );
+      CHECK_NEAR( stop.seconds(), 2 * (L / v + v / a), 1e-12 );
+    }
+
+    ///5. Arcs cruise no faster than centripetal acceleration allows
+    {
+      Motion m( a, d );
+      double r = u(rng);
+      CHECK_NEAR( m.arc( v, r ), std::min( v, sqrt( a * r ) ), 1e-12 );
+    }
+  }
+
+  ///6. A square of side L cut from a pierce at a corner back to it: in at
+  ///   rest, through three corners at the junction speed, out at rest
+  {
+    double L = 4, a = 20, d = .002;
+    Profile f;
+    f.acceleration = a;
+    f.deviation = d;
+    Data data = test::Read( test::Part().polygon( { { 0, 0 }, { L, 0 }, { L, L }, { 0, L } } ) );
+    double s = sqrt( .5 ), v = f.velocity, vj = std::min( v, sqrt( a * d * s / (1 - s) ) );
+    double t = 2 * Trapezoid( L, v, 0, vj, a ) + 2 * Trapezoid( L, v, vj, vj, a );
+    CHECK_NEAR( data.seconds(f), t, 1e-12 );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,138 @@
+/// Checks that Nest keeps every placed outline on its sheet and clear of
+/// the others by the spacing, that a fixed seed and number of steps give
+/// the same nesting each run, and that nestings are priced and shared cuts
+/// timed at the velocities and prices of the profile
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Do convex loops a and b stand apart by at least d along a normal of one of their edges?
+bool Apart( const std::vector<Vec2>& a, const std::vector<Vec2>& b, double d ){
+  for (int k=0;k<2;++k){
+    auto& p = k ? b : a;
+    int n = p.size();
+    for (int i=0;i<n;++i){
+      Vec2 e = ( p[(i+1)%n] - p[i] ).unit(), m = { e.y, -e.x };
+      double a0 = 1e300, a1 = -1e300, b0 = 1e300, b1 = -1e300;
+      for (auto& v : a) { a0 = std::min( a0, Vec2::Dot( m, v ) ); a1 = std::max( a1, Vec2::Dot( m, v ) ); }
+      for (auto& v : b) { b0 = std::min( b0, Vec2::Dot( m, v ) ); b1 = std::max( b1, Vec2::Dot( m, v ) ); }
+      if (b0 - a1 >= d - 1e-9 || a0 - b1 >= d - 1e-9) return true;
+    }
+  }
+  return false;
+}
+
+/// Check placements of a nesting on sheets of stock: inside, apart by spacing
+void Placed( const Nest& nest, const Nest::Result& r, const std::vector<Nest::Sheet>& stock, double spacing ){
+  CHECK( r.placement.size() == nest.size() );
+  std::vector< std::vector< std::vector<Vec2> > > sheets( r.sheets() );
+  for (auto& p : r.placement){
+    CHECK( p.sheet >= 0 && p.sheet < r.sheets() );
+    const Nest::Sheet& s = stock[ r.stock[p.sheet] ];
+    std::vector<Vec2> loop;
+    for (auto& v : nest.outline( p.part, p.rotation ).points){
+      Vec2 w = v + p.position;
+      CHECK( w.x >= -1e-9 && w.y >= -1e-9 && w.x <= s.width + 1e-9 && w.y <= r.used[p.sheet] + 1e-9 );
+      loop.push_back( w );
+    }
+    CHECK( r.used[p.sheet] <= s.height + 1e-9 );
+    for (auto& other : sheets[p.sheet]) CHECK( Apart( loop, other, spacing ) );
+    sheets[p.sheet].push_back( loop );
+  }
+}
+
+int main(){
+
+  std::mt19937 rng( 32 );
+  std::uniform_real_distribution<double> u( -1, 1 ), side( 1, 6 ), radius( .1, .8 );
+
+  ///1. Rectangles, rounded rectangles, triangles and random convex polygons
+  std::vector<test::Part> parts;
+  for (int k=0;k<8;++k){
+    double w = side(rng), h = side(rng);
+    double r[4] = { radius(rng), radius(rng), radius(rng), radius(rng) };
+    std::vector<Vec2> cloud;
+    for (int i=0;i<12;++i) cloud.push_back( { 2 * u(rng), 2 * u(rng) } );
+    switch (k % 4){
+      case 0: parts.push_back( test::Part().polygon( { {0,0}, {w,0}, {w,h}, {0,h} } ) ); break;
+      case 1: parts.push_back( test::Part().rounded( w, h, r ) ); break;
+      case 2: parts.push_back( test::Part().polygon( { {0,0}, {w,0}, {0,h} } ) ); break;
+      default: parts.push_back( test::Part().polygon( Hull::Convex( cloud ) ) ); break;
+    }
+  }
+  std::vector<Nest::Sheet> stock = { { 12, 12 }, { 24, 18 } };
+  auto build = [&]( Nest& nest, double spacing, int steps, unsigned seed ){
+    for (auto& s : stock) nest.stock( s.width, s.height );
+    nest.spacing( spacing );
+    nest.steps( steps );
+    nest.seed( seed );
+    nest.tolerance( .05 );
+    nest.threads( 3 );
+    for (size_t i=0;i<parts.size();++i){
+      Data data = test::Read( parts[i] );
+      nest.add( data, 1 + i % 3 );
+    }
+  };
+
+  ///2. Every placement on its sheet and apart by the spacing, with and without spacing
+  for (double spacing : { Material::Padding, .25, 0.0 }){
+    Nest nest;
+    build( nest, spacing, 0, 0 );
+    nest.budget( std::chrono::milliseconds( 50 ) );
+    Placed( nest, nest.run(), stock, spacing );
+  }
+
+  ///3. A fixed seed and number of steps: the same nesting every run
+  for (unsigned seed : { 1u, 7u }){
+    Nest a, b;
+    build( a, Material::Padding, 20, seed );
+    build( b, Material::Padding, 20, seed );
+    Nest::Result x = a.run(), y = b.run();
+    Placed( a, x, stock, Material::Padding );
+    CHECK( x.sheets() == y.sheets() && x.stock == y.stock && x.used == y.used );
+    CHECK( x.area == y.area && x.cost == y.cost );
+    bool same = true;
+    for (size_t i=0;i<x.placement.size();++i){
+      auto& p = x.placement[i];
+      auto& q = y.placement[i];
+      same &= p.sheet == q.sheet && p.rotation == q.rotation && p.position == q.position;
+    }
+    CHECK( same );
+    // utilization: the parts' outlines within the material consumed
+    double parts = 0;
+    for (auto& p : x.placement){
+      auto& o = a.outline( p.part, p.rotation ).points;
+      for (size_t i=0;i<o.size();++i) parts += Vec2::Cross( o[i], o[(i+1)%o.size()] ) / 2;
+    }
+    CHECK( parts > 0 && parts <= x.area );
+    printf( "seed %u: %d sheets, %.1f%% used\n", seed, x.sheets(), 100 * parts / x.area );
+  }
+
+  ///4. Squares side by side without spacing share cuts, timed at the profile's velocity
+  {
+    Profile f;
+    f.velocity = 2;
+    f.perSecond = .5;
+    f.perUnitArea = .25;
+    Nest nest;
+    nest.stock( 4, 2 );
+    nest.spacing( 0 );
+    nest.profile( f );
+    nest.steps( 1 );
+    nest.threads( 1 );
+    Data data = test::Read( test::Part().polygon( { {0,0}, {2,0}, {2,2}, {0,2} } ) );
+    nest.add( data, 2 );
+    Nest::Result r = nest.run();
+    CHECK( r.sheets() == 1 );
+    CHECK_NEAR( r.common, 2, 1e-9 );
+    CHECK_NEAR( r.seconds, 2 * data.seconds(f) - r.common / f.velocity, 1e-9 );
+    CHECK_NEAR( r.cost, r.seconds * f.perSecond + r.area * f.perUnitArea, 1e-9 );
+    CHECK_NEAR( r.area, 8, 1e-9 );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,170 @@
+/// Checks Offset::Loop against the lengths and areas of exact offsets:
+/// rectangles and rounded rectangles grown (round corners) and shrunk
+/// (corners sharpened where the offset passes their radius), either way
+/// round, and a square with a shallow circular bite shrunk; and that on
+/// random loops of lines and arcs every trimmed arc still ends where its
+/// sweep takes it, turning no more than a crossing moves its ends
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Straight piece from a to b
+Piece Line( Vec2 a, Vec2 b ){
+  Piece p;
+  p.a = a; p.b = b;
+  return p;
+}
+
+/// Arc from a about c by sweep
+Piece Arc( Vec2 c, double r, double from, double sweep ){
+  Piece p;
+  p.center = c;
+  p.a = Vec2::Construct( c, from, r );
+  p.b = Vec2::Construct( c, from + sweep, r );
+  p.sweep = sweep;
+  return p;
+}
+
+/// Total length of a loop
+double Length( const std::vector<Piece>& loop ){
+  double s = 0;
+  for (auto& p : loop) s += p.length();
+  return s;
+}
+
+/// Does each piece start where the one before ends, and end where its sweep takes it?
+bool Joined( const std::vector<Piece>& loop ){
+  for (size_t i=0;i<loop.size();++i){
+    auto& p = loop[i];
+    if ((p.a - loop[ (i + loop.size() - 1) % loop.size() ].b).norm() > 1e-9) return false;
+    if (p.arc() && (Vec2::Construct( p.center, Vec2::Theta( p.a - p.center ) + p.sweep, p.radius() ) - p.b).norm() > 1e-9) return false;
+  }
+  return true;
+}
+
+/// Loop travelled the other way round
+std::vector<Piece> Reversed( std::vector<Piece> loop ){
+  std::reverse( loop.begin(), loop.end() );
+  for (auto& p : loop) p = p.reversed();
+  return loop;
+}
+
+/// Counterclockwise w x h rectangle from the origin, corners rounded by r[4]
+/// (corner i of (w,0), (w,h), (0,h), (0,0)), straight where r[i] is 0
+std::vector<Piece> Rounded( double w, double h, const double r[4] ){
+  Vec2 c[4] = { { w-r[0], r[0] }, { w-r[1], h-r[1] }, { r[2], h-r[2] }, { r[3], r[3] } };
+  std::vector<Piece> loop;
+  for (int i=0;i<4;++i){
+    double from = PI/2 * (i - 1);
+    if (r[i] > 0) loop.push_back( Arc( c[i], r[i], from, PI/2 ) );
+    Vec2 a = Vec2::Construct( c[i], from + PI/2, r[i] ), b = Vec2::Construct( c[(i+1)%4], from + PI/2, r[(i+1)%4] );
+    loop.push_back( Line( a, b ) );
+  }
+  return loop;
+}
+
+int main(){
+
+  std::mt19937 rng( 39 );
+  std::uniform_real_distribution<double> side( 1, 10 ), radius( 0, .8 ), offset( .01, .5 );
+
+  ///1. Grown by d: sides unchanged, corners of radius r + d (about each
+  ///   sharp corner, a quarter turn of radius d); area A + P d + PI d^2
+  ///2. Shrunk by d: sides shortened to the corners of radius r - d, or to
+  ///   sharp corners where r <= d; area of the eroded box less the corners
+  for (int k=0;k<200;++k){
+    double w = side(rng), h = side(rng), d = offset(rng), r[4];
+    for (auto& i : r) i = k % 4 == 0 ? 0 : radius(rng);
+    if (k % 8 == 1) r[rng() % 4] = 0;
+    auto loop = Rounded( w, h, r );
+    double P = 2 * (w + h), A = w * h;
+    for (double i : r) { P -= (2 - PI/2) * i; A -= (1 - PI/4) * i * i; }
+    for (int way=0;way<2;++way){
+      auto l = way ? Reversed( loop ) : loop;
+      CHECK_NEAR( fabs( Offset::Area( l ) ), A, 1e-9 );
+
+      auto grown = Offset::Loop( l, d );
+      CHECK( Joined( grown ) );
+      CHECK_NEAR( Length( grown ), P + 2*PI*d, 1e-9 );
+      CHECK_NEAR( fabs( Offset::Area( grown ) ), A + P*d + PI*d*d, 1e-9 );
+
+      // each side runs between its corners' ends, max( r, d ) in from the box;
+      // where corners overlap the offset is narrower than the feature (not removed)
+      double sides = 0, arcs = 0, cut = 0, e[4];
+      for (int i=0;i<4;++i) e[i] = std::max( r[i], d );
+      double run[4] = { h - e[0] - e[1], w - e[1] - e[2], h - e[2] - e[3], w - e[3] - e[0] };
+      if (*std::min_element( run, run + 4 ) < 0) continue;
+      for (int i=0;i<4;++i){
+        sides += run[i];
+        if (r[i] <= d) continue;
+        arcs += PI/2 * (r[i] - d);
+        cut += (1 - PI/4) * (r[i] - d) * (r[i] - d);
+      }
+      auto shrunk = Offset::Loop( l, -d );
+      CHECK( Joined( shrunk ) );
+      CHECK_NEAR( Length( shrunk ), sides + arcs, 1e-9 );
+      CHECK_NEAR( fabs( Offset::Area( shrunk ) ), (w - 2*d) * (h - 2*d) - cut, 1e-9 );
+    }
+  }
+
+  ///3. A 4 x 4 square with a bite of radius q about (0, 2 + c) from its top
+  ///   side, shrunk by d: the square of side 4 - 2d less the segment of the
+  ///   circle of radius q + d cut by the side moved to 2 - d
+  for (int k=0;k<50;++k){
+    double q = 1 + .5 * radius(rng), c = .6 * q + .3 * q * radius(rng), d = .05 + .2 * radius(rng);
+    double half = sqrt( q*q - c*c ), a = atan2( -c, half );
+    std::vector<Piece> loop = {
+      Line( { -2, -2 }, { 2, -2 } ), Line( { 2, -2 }, { 2, 2 } ), Line( { 2, 2 }, { half, 2 } ),
+      Arc( { 0, 2 + c }, q, a, -(PI + 2*a) ), Line( { -half, 2 }, { -2, 2 } ), Line( { -2, 2 }, { -2, -2 } ) };
+    CHECK( Joined( loop ) );
+    double R = q + d, t = c + d, chord = sqrt( R*R - t*t );
+    double area = (4 - 2*d) * (4 - 2*d) - ( R*R * acos( t / R ) - t * chord );
+    double length = 4 * (4 - 2*d) - 2 * chord + 2 * R * acos( t / R );
+    for (int way=0;way<2;++way){
+      auto shrunk = Offset::Loop( way ? Reversed( loop ) : loop, -d );
+      CHECK( Joined( shrunk ) );
+      CHECK_NEAR( Length( shrunk ), length, 1e-9 );
+      CHECK_NEAR( fabs( Offset::Area( shrunk ) ), area, 1e-9 );
+    }
+  }
+
+  ///4. Random star-shaped loops of lines and arcs bulging either way, moved
+  ///   either way by up to a tenth of their size: trims that pass each other
+  ///   turn an arc back a little, as they would a line, never on round
+  for (int k=0;k<5000;++k){
+    int n = 3 + k % 5;
+    std::vector<double> at;
+    for (int i=0;i<n;++i) at.push_back( 2*PI * radius(rng) / .8 );
+    std::sort( at.begin(), at.end() );
+    std::vector<Piece> loop;
+    for (int i=0;i<n;++i){
+      Vec2 a = Vec2::Construct( Vec2{ 0, 0 }, at[i], 1 + radius(rng) );
+      Vec2 b = i + 1 < n ? Vec2() : loop[0].a;
+      if (i + 1 < n) b = Vec2::Construct( Vec2{ 0, 0 }, at[i+1], 1 + radius(rng) );
+      if (i > 0) a = loop.back().b;
+      Piece p = Line( a, b );
+      if (k % 3 && rng() % 2){
+        // about a center on the bisector of the chord, sweeping either way by up to 2.5
+        double sweep = std::max( .1, 2.5 * radius(rng) / .8 ) * (rng() % 2 ? 1 : -1);
+        Vec2 m = { (a.x + b.x) / 2, (a.y + b.y) / 2 }, u = (b - a).unit();
+        double half = (b - a).norm() / 2, t = half / tan( sweep / 2 );
+        p.center = m + Vec2{ -u.y * t, u.x * t };
+        p.sweep = sweep;
+      }
+      loop.push_back( p );
+    }
+    CHECK( Joined( loop ) );
+    auto moved = Offset::Loop( loop, .1 * (radius(rng) / .4 - 1) );
+    CHECK( Joined( moved ) );
+    for (auto& q : moved){
+      if (!q.arc() || q.bJoin) continue;
+      for (auto& p : loop) if (p.arc() && p.center == q.center) CHECK( fabs( q.sweep ) < fabs( p.sweep ) + 1 );
+    }
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,111 @@
+/// Checks that Pack keeps every rectangle on its sheet and clear of the
+/// others by the spacing, in either orientation, that its sheet count and
+/// utilization agree with the placements, that a rectangle larger than the
+/// stock is refused, and prints the time it takes for tens of thousands
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <random>
+
+using namespace cc;
+
+typedef std::chrono::steady_clock Clock;
+
+/// Check a packing of rects on w x h sheets: inside, apart by spacing
+void Placed( const std::vector<Pack::Rect>& rects, const Pack::Result& r, double w, double h, double spacing ){
+  CHECK( r.placement.size() == rects.size() );
+  // lower left and upper right corners of each placed rectangle, by sheet
+  std::vector< std::vector< std::pair<Vec2,Vec2> > > sheets( r.sheets );
+  double area = 0;
+  for (size_t i=0;i<rects.size();++i){
+    auto& p = r.placement[i];
+    CHECK( p.sheet >= 0 && p.sheet < r.sheets );
+    double x = p.bRotated ? rects[i].height : rects[i].width;
+    double y = p.bRotated ? rects[i].width : rects[i].height;
+    Vec2 a = p.position, b = p.position + Vec2{ x, y };
+    CHECK( a.x >= -1e-9 && a.y >= -1e-9 && b.x <= w + 1e-9 && b.y <= h + 1e-9 );
+    sheets[p.sheet].push_back( { a, b } );
+    area += x * y;
+  }
+  // sweep each sheet left to right: only rectangles within spacing in x can be too near
+  for (auto& s : sheets){
+    std::sort( s.begin(), s.end(), []( const std::pair<Vec2,Vec2>& a, const std::pair<Vec2,Vec2>& b ){ return a.first.x < b.first.x; } );
+    for (size_t i=0;i<s.size();++i){
+      for (size_t j=i+1;j<s.size() && s[j].first.x < s[i].second.x + spacing - 1e-9;++j){
+        bool apart = s[j].first.y >= s[i].second.y + spacing - 1e-9 || s[i].first.y >= s[j].second.y + spacing - 1e-9;
+        CHECK( apart );
+      }
+    }
+    CHECK( !s.empty() );
+  }
+  CHECK_NEAR( r.area, area, 1e-9 );
+  CHECK_NEAR( r.utilization, area / (r.sheets * w * h), 1e-12 );
+  CHECK( r.utilization > 0 && r.utilization <= 1 );
+}
+
+int main(){
+
+  std::mt19937 rng( 34 );
+  std::uniform_real_distribution<double> side( .5, 8 ), thin( .1, 1 );
+
+  ///1. Random rectangles, some long and thin, with and without spacing
+  for (double spacing : { Material::Padding, .5, 0.0 }){
+    for (int open : { 1, 4 }){
+      std::vector<Pack::Rect> rects;
+      Pack pack;
+      pack.stock( 24, 18 );
+      pack.spacing( spacing );
+      pack.open( open );
+      for (int i=0;i<2000;++i){
+        Pack::Rect r = { side(rng), i % 5 ? side(rng) : thin(rng) };
+        // long rectangles only fit across the sheet one way
+        if (i % 50 == 0) r.width = 20;
+        rects.push_back( r );
+        pack.add( r.width, r.height );
+      }
+      Placed( rects, pack.run(), 24, 18, spacing );
+    }
+  }
+
+  ///2. Equal squares that tile the sheet exactly: one sheet, fully used
+  {
+    Pack pack;
+    pack.stock( 10, 6 );
+    pack.spacing( 0 );
+    pack.add( 2, 2, 15 );
+    Pack::Result r = pack.run();
+    CHECK( r.sheets == 1 );
+    CHECK_NEAR( r.utilization, 1, 1e-12 );
+  }
+
+  ///3. A rectangle larger than the stock either way is refused
+  {
+    Pack pack;
+    pack.stock( 10, 6 );
+    pack.add( 2, 2, 3 );
+    pack.add( 7, 7 );
+    bool refused = false;
+    try { pack.run(); } catch (std::invalid_argument&) { refused = true; }
+    CHECK( refused );
+  }
+
+  ///4. Time tens of thousands of rectangles
+  for (int n : { 10000, 50000 }){
+    std::vector<Pack::Rect> rects;
+    Pack pack;
+    pack.stock( 48, 96 );
+    for (int i=0;i<n;++i){
+      rects.push_back( { side(rng), side(rng) } );
+      pack.add( rects.back().width, rects.back().height );
+    }
+    auto t0 = Clock::now();
+    Pack::Result r = pack.run();
+    double ms = std::chrono::duration<double,std::milli>( Clock::now() - t0 ).count();
+    Placed( rects, r, 48, 96, Material::Padding );
+    printf( "%d rectangles: %d sheets, %.1f%% used, %.1fms\n", n, r.sheets, 100 * r.utilization, ms );
+  }
+
+  return test::Report();
+}
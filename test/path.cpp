@@ -0,0 +1,142 @@
+/// Checks that Path::Plan finds the shortest travel through squares and
+/// open segments along a line, whatever order they are read in, that Data
+/// plans its path once per read and again after fit(), and that
+/// Path::Classify nests loops to any depth, with rays along the lattice
+/// lines of other loops' vertices and across bands, and open chains inside
+/// them
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+int main(){
+
+  std::mt19937 rng( 37 );
+
+  ///1. Unit squares three apart along a line, read in any order: any path
+  ///   from the first to the last spans the two gaps between them, 3n - 4,
+  ///   and visits them in order along the line
+  for (int n : { 2, 3, 10, 40 }){
+    for (int k=0;k<5;++k){
+      std::vector<int> order( n );
+      for (int i=0;i<n;++i) order[i] = i;
+      std::shuffle( order.begin(), order.end(), rng );
+      test::Part part;
+      for (int i : order){
+        double x = 3 * i;
+        std::vector<Vec2> p = { { x, 0 }, { x+1, 0 }, { x+1, 1 }, { x, 1 } };
+        std::rotate( p.begin(), p.begin() + rng() % 4, p.end() );
+        part.polygon( p );
+      }
+      Data data = test::Read( part );
+      CHECK_NEAR( data.summary().travel, 3*n - 4, 1e-9 );
+      std::vector<Loop> loops;
+      for (int i=0;i<n;++i){
+        Loop l;
+        l.bClosed = true;
+        l.points = { part.vertices[4*i], part.vertices[4*i+1], part.vertices[4*i+2], part.vertices[4*i+3] };
+        loops.push_back( l );
+      }
+      auto stops = Path::Plan( loops );
+      CHECK( (int)stops.size() == n );
+      CHECK_NEAR( Path::Travel( stops ), 3*n - 4, 1e-9 );
+      bool monotone = true;
+      int dir = order[ stops.back().loop ] > order[ stops.front().loop ] ? 1 : -1;
+      for (int i=1;i<n;++i) monotone &= order[ stops[i].loop ] == order[ stops[i-1].loop ] + dir;
+      CHECK( monotone );
+    }
+  }
+
+  ///2. Open segments of length one, one apart along a line, either way
+  ///   round: each entered at one end and left at the other, n - 1 of travel
+  for (int n : { 2, 5, 30 }){
+    std::vector<Loop> loops;
+    for (int i=0;i<n;++i){
+      Loop l;
+      l.points = { { 2.0 * i, 0 }, { 2.0 * i + 1, 0 } };
+      if (rng() & 1) std::swap( l.points[0], l.points[1] );
+      loops.push_back( l );
+    }
+    std::shuffle( loops.begin(), loops.end(), rng );
+    auto stops = Path::Plan( loops );
+    CHECK_NEAR( Path::Travel( stops ), n - 1, 1e-9 );
+    for (auto& s : stops) CHECK( (s.in - s.out).norm() == 1 );
+  }
+
+  ///3. Planned once per read: seconds agree when asked again, and the plan
+  ///   follows fit() as a fresh read does: the vertex of a rectangle nearest
+  ///   a diamond, in the middle of its side, goes with the side's run
+  {
+    test::Part part;
+    part.polygon( { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 1, 2 }, { 0, 2 } } );
+    part.polygon( { { 3, 1 }, { 4, 0 }, { 5, 1 }, { 4, 2 } } );
+    Data data = test::Read( part );
+    double secs = data.seconds();
+    CHECK( data.seconds() == secs );
+    CHECK_NEAR( data.summary().travel, 2, 1e-12 );
+    CHECK( data.fit( 1e-3 ) > 0 );
+    Data fresh = test::Read( part );
+    fresh.fit( 1e-3 );
+    CHECK( data.seconds() == fresh.seconds() );
+    CHECK_NEAR( data.summary().travel, sqrt( 5.0 ), 1e-12 );
+  }
+
+  ///4. Cells of a lattice, each with up to five nested squares or diamonds
+  ///   (plate, hole, island, ...) and an open chain inside the innermost:
+  ///   rays run along rows of other cells' vertices and edges through bands
+  for (int k=0;k<20;++k){
+    int cells = 1 + k % 6;
+    std::vector<Loop> loops;
+    std::vector< std::vector<Vec2> > polygons;
+    std::vector<int> depth, parent;
+    for (int cx=0;cx<cells;++cx){
+      for (int cy=0;cy<cells;++cy){
+        int levels = rng() % 6;
+        bool diamond = rng() & 1;
+        for (int d=0;d<=levels;++d){
+          double x = 12 * cx, y = 12 * cy, a = d, b = 10 - d;
+          std::vector<Vec2> p;
+          if (d == levels){
+            // open chain inside the innermost loop, level with diamonds' vertices
+            p = { { x + 4.75, y + 5 }, { x + 5.25, y + 5 } };
+          } else if (diamond){
+            double c = 5, r = 5 - d;
+            p = { { x + c, y + c - r }, { x + c + r, y + c }, { x + c, y + c + r }, { x + c - r, y + c } };
+          } else p = { { x + a, y + a }, { x + b, y + a }, { x + b, y + b }, { x + a, y + b } };
+          if (rng() & 1) std::reverse( p.begin(), p.end() );
+          std::rotate( p.begin(), p.begin() + rng() % p.size(), p.end() );
+          Loop l;
+          l.points = p;
+          l.bClosed = d < levels;
+          double area = 0;
+          for (size_t i=0;i<p.size();++i) area += Vec2::Cross( p[i], p[(i+1)%p.size()] ) / 2;
+          l.area = l.bClosed ? area : 0;
+          loops.push_back( l );
+          polygons.push_back( l.bClosed ? p : std::vector<Vec2>() );
+          depth.push_back( d );
+          parent.push_back( d > 0 ? (int)loops.size() - 2 : -1 );
+        }
+      }
+    }
+    // shuffle, keeping track of where each loop goes
+    std::vector<int> order( loops.size() ), at( loops.size() );
+    for (size_t i=0;i<order.size();++i) order[i] = i;
+    std::shuffle( order.begin(), order.end(), rng );
+    for (size_t i=0;i<order.size();++i) at[ order[i] ] = i;
+    std::vector<Loop> shuffled;
+    std::vector< std::vector<Vec2> > shapes;
+    for (int i : order) { shuffled.push_back( loops[i] ); shapes.push_back( polygons[i] ); }
+    Path::Classify( shuffled, shapes );
+    bool nested = true;
+    for (size_t i=0;i<order.size();++i){
+      int j = order[i];
+      nested &= shuffled[i].depth == depth[j] && shuffled[i].parent == ( parent[j] < 0 ? -1 : at[ parent[j] ] );
+    }
+    CHECK( nested );
+  }
+
+  return test::Report();
+}
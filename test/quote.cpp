@@ -0,0 +1,91 @@
+/// Checks that every estimate of Data::quote holds the padded area of the
+/// part between its bounds, for rounded rectangles at any turn with padding
+/// and kerf and for arcs closed by a chord, and that an expired budget stops
+/// it before the time is known
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Part turned by t about the origin
+test::Part Turn( test::Part part, double t ){
+  auto turn = [&]( Vec2 v ){ return Vec2{ v.x * cos(t) - v.y * sin(t), v.x * sin(t) + v.y * cos(t) }; };
+  for (auto& v : part.vertices) v = turn( v );
+  for (auto& e : part.edges) e.center = turn( e.center );
+  return part;
+}
+
+int main(){
+
+  std::mt19937 rng( 47 );
+  std::uniform_real_distribution<double> side( 1, 10 ), radius( .05, .5 ), turn( 0, 2*PI ), pad( 0, 1 );
+
+  ///1. Padded area of the exact box (w + p)(h + p), and of the box of steps
+  ///   at a finer power of two (which hold every estimate's steps), within bounds
+  const int fine = 1 << 12;
+  Cancel forever;
+  for (int k=0;k<40;++k){
+    double w = side(rng), h = side(rng), t = turn(rng);
+    double r[4] = { radius(rng), radius(rng), radius(rng), radius(rng) };
+    Data data = test::Read( Turn( test::Part().rounded( w, h, r ), t ), fine );
+    Profile f;
+    f.padding = pad(rng);
+    f.kerf = k % 2 ? pad(rng) / 10 : 0;
+    double p = f.padding + f.kerf, exact = (w + p) * (h + p), steps = data.area(f);
+    int reports = 0;
+    Progress last = data.quote( f, 1e-3, forever, [&]( const Progress& e ){
+      reports++;
+      CHECK( e.area <= exact * (1 + 1e-12) && exact <= e.upper * (1 + 1e-12) );
+      if (e.resolution <= fine) CHECK( e.area <= steps * (1 + 1e-9) && steps <= e.upper * (1 + 1e-9) );
+      CHECK_NEAR( e.seconds, data.seconds(f), 1e-12 );
+    } );
+    CHECK( reports > 1 && last.resolution > 1 );
+  }
+
+  ///2. Runs of arcs on the unit circle closed by a chord, whose vertices may
+  ///   hull to a segment: the same, against the box of finer steps
+  for (int k=0;k<60;++k){
+    test::Part part;
+    int n = 2 + k % 3;
+    std::vector<double> at;
+    for (int i=0;i<n;++i) at.push_back( turn(rng) );
+    std::sort( at.begin(), at.end() );
+    for (double a : at) part.vertex( { cos(a), sin(a) } );
+    for (int i=1;i<n;++i) part.arc( i, i+1, { 0, 0 } );
+    part.line( n, 1 );
+    Data data = test::Read( part, fine );
+    Profile f;
+    f.padding = 2 * pad(rng);
+    double steps = data.area(f);
+    data.quote( f, 1e-3, forever, [&]( const Progress& e ){
+      if (e.resolution <= fine) CHECK( e.area <= steps * (1 + 1e-9) && steps <= e.upper * (1 + 1e-9) );
+    } );
+  }
+
+  ///3. Without padding the bound is reached
+  {
+    double r[4] = { .5, .5, .5, .5 };
+    Data data = test::Read( test::Part().rounded( 4, 3, r ) );
+    Profile f;
+    f.padding = 0;
+    Progress e = data.quote( f, 1e-4, forever );
+    CHECK( e.bCertified && e.error <= 1e-4 );
+    CHECK( e.area <= 12 * (1 + 1e-12) && 12 <= e.upper * (1 + 1e-12) );
+  }
+
+  ///4. An expired budget stops before the time: no estimate is reported
+  {
+    double r[4] = { .5, .5, .5, .5 };
+    Data data = test::Read( test::Part().rounded( 4, 3, r ) );
+    Cancel expired;
+    expired.cancel();
+    int reports = 0;
+    Progress e = data.quote( Profile(), 1e-4, expired, [&]( const Progress& ){ reports++; } );
+    CHECK( reports == 0 && e.resolution == 0 && !e.bCertified );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,247 @@
+/// Checks that coalesced quote requests are each answered by their own
+/// deadline: a leader running out of time hands the flight on to followers
+/// with time left, and only followers out of time are answered Expired; that
+/// a request its caller cancels does not fail another for the same part;
+/// that full lanes answer Overloaded, large parts TooLarge, and cancelled or
+/// late requests Expired; that a cached quote whose check disagrees with
+/// the request's is not served; and that snapshot write errors reach the
+/// caller.  Time is passed to the flight
+/// and expiry driven by cancelling, so nothing waits on the clock
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <fstream>
+#include <sstream>
+
+using namespace cc;
+
+typedef Cancel::Clock Clock;
+typedef SingleFlight<int,Quote> Flight;
+
+bool Ready( std::future<Quote>& f ){
+  return f.wait_for( std::chrono::seconds(0) ) == std::future_status::ready;
+}
+
+int main(){
+
+  ///1. SingleFlight: the impatient compute alone, and promote() expires only the late
+  {
+    Flight flight;
+    auto now = Clock::now();
+    std::promise<Quote> lead, late, patient, impatient;
+    auto lateResult = late.get_future(), patientResult = patient.get_future();
+    CHECK( flight.join( 1, lead, now + std::chrono::milliseconds(20) ) == Flight::Lead );
+    CHECK( flight.join( 1, late, now + std::chrono::milliseconds(30) ) == Flight::Follow );
+    CHECK( flight.join( 1, patient, now + std::chrono::seconds(30) ) == Flight::Follow );
+    CHECK( flight.join( 1, impatient, now + std::chrono::milliseconds(10) ) == Flight::Alone );
+
+    Quote expired; expired.status = Quote::Expired;
+    auto deadline = now;
+    CHECK( flight.promote( 1, expired, deadline, now + std::chrono::milliseconds(50) ) );
+    CHECK( deadline == now + std::chrono::seconds(30) );
+    CHECK( Ready( lateResult ) && lateResult.get().status == Quote::Expired );
+    CHECK( !Ready( patientResult ) );
+
+    Quote ok; ok.cost = 1;
+    flight.land( 1, ok );
+    CHECK( Ready( patientResult ) && patientResult.get().status == Quote::Ok );
+    CHECK( flight.size() == 0 );
+    CHECK( !flight.promote( 1, expired, deadline ) );
+  }
+
+  ///2. QuoteService: a request with time left is not failed by one for the
+  ///   same part its caller gave up on, whichever of them runs first
+  for (int k=0;k<20;++k){
+    std::ifstream in( "files/ExtrudeCircularArc.json" );
+    std::stringstream json;
+    json << in.rdbuf();
+
+    Limits limits;
+    limits.workers = 2;
+    limits.fastWorkers = 0;
+    QuoteService service( limits );
+
+    Cancel gone;
+    gone.cancel();
+    Request hurried, patient;
+    hurried.json = patient.json = json.str();
+    hurried.resolution = patient.resolution = 200 + k;
+    hurried.cancel = &gone;
+    patient.deadline = std::chrono::milliseconds(30000);
+
+    auto first = service.submit( hurried );
+    auto second = service.submit( patient );
+
+    Quote a = first.get(), b = second.get();
+    CHECK( a.status == Quote::Expired );
+    CHECK( b.status == Quote::Ok );
+    CHECK( b.cost > 0 );
+  }
+
+  ///3. Analysis under a token that expires with the caller's, not after it
+  {
+    Cancel caller, token( Clock::time_point::max(), &caller );
+    CHECK( !token.expired() );
+    caller.cancel();
+    CHECK( token.expired() );
+    Cancel late( Clock::now() - std::chrono::seconds(1) ), child( Clock::time_point::max(), &late );
+    CHECK( child.expired() );
+  }
+
+  ///4. Lanes filled while workers are held: each takes queue requests and
+  ///   answers the next Overloaded at once; on release, cancelled and late
+  ///   requests are Expired and the rest priced
+  {
+    std::ifstream in( "files/Rectangle.json" );
+    std::stringstream json;
+    json << in.rdbuf();
+    std::string small = json.str(), large = small + std::string( 100, ' ' );
+
+    Limits limits;
+    limits.queue = 3;
+    limits.small = small.size() + 1;
+    limits.workers = 2;
+    limits.fastWorkers = 1;
+    QuoteService service( limits );
+    service.hold( true );
+
+    Cancel gone;
+    std::vector< std::future<Quote> > fast, slow;
+    for (int i=0;i<3;++i){
+      Request r;
+      r.json = small;
+      if (i == 1) r.cancel = &gone;
+      if (i == 2) r.deadline = std::chrono::milliseconds(1);
+      fast.push_back( service.submit( r ) );
+      r.json = large;
+      r.cancel = nullptr;
+      slow.push_back( service.submit( r ) );
+    }
+    CHECK( service.queued() == 6 );
+    for (auto* json : { &small, &large }){
+      Request r;
+      r.json = *json;
+      auto over = service.submit( r );
+      CHECK( Ready( over ) );
+      Quote q = over.get();
+      CHECK( q.status == Quote::Overloaded && q.error == "Error: Queue Full." );
+    }
+    for (auto& f : fast) CHECK( !Ready( f ) );
+    gone.cancel();
+    std::this_thread::sleep_for( std::chrono::milliseconds(5) );   // past the 1ms deadlines
+    service.hold( false );
+
+    Quote q[2][3];
+    for (int i=0;i<3;++i) { q[0][i] = fast[i].get(); q[1][i] = slow[i].get(); }
+    CHECK( q[0][0].status == Quote::Ok && q[1][0].status == Quote::Ok && q[0][0].cost > 0 );
+    CHECK( q[0][1].status == Quote::Expired && q[0][1].error == "Error: Cancelled In Queue." );
+    CHECK( q[1][1].status == Quote::Ok );
+    CHECK( q[0][2].status == Quote::Expired && q[0][2].error == "Error: Deadline Passed In Queue." );
+    CHECK( q[1][2].status == Quote::Expired && q[1][2].error == "Error: Deadline Passed In Queue." );
+    CHECK( service.queued() == 0 );
+  }
+
+  ///5. Too many points to analyze, and requests still held at shutdown
+  {
+    std::ifstream in( "files/ExtrudeCircularArc.json" );
+    std::stringstream json;
+    json << in.rdbuf();
+    std::future<Quote> big, held;
+    {
+      Limits limits;
+      limits.points = 1000;
+      limits.workers = 1;
+      QuoteService service( limits );
+      Request r;
+      r.json = json.str();
+      r.resolution = 1000;
+      big = service.submit( r );
+      CHECK( big.get().status == Quote::TooLarge );
+      r.resolution = 20;
+      CHECK( service.submit( r ).get().status == Quote::Ok );
+      service.hold( true );
+      held = service.submit( r );
+    }
+    Quote q = held.get();
+    CHECK( q.status == Quote::Overloaded && q.error == "Error: Service Stopped." );
+  }
+
+  ///6. A cache entry under the request's key but another check (keys alike
+  ///   by chance) is analyzed over, and one that agrees is served
+  {
+    std::ifstream in( "files/Rectangle.json" );
+    std::stringstream json;
+    json << in.rdbuf();
+    Data data;
+    std::istringstream stream( json.str() );
+    data.read( stream );
+    Profile f;
+    uint64_t key = QuoteService::Key( data.hash(), 20, f ), check = QuoteService::Check( data.check(), 20, f );
+
+    std::string name = "/cccheck" + std::to_string( getpid() );
+    SharedCache::Remove( name );
+    SharedCache cache( name, 64 );
+    QuoteService service;
+    service.cache( &cache );
+    Request r;
+    r.json = json.str();
+    cache.insert( key, { 1, 1, 1, check ^ 1 } );
+    Quote q = service.submit( r ).get();
+    CHECK( q.status == Quote::Ok && q.cost != 1 );
+    SharedCache::Value v;
+    CHECK( cache.find( key, v ) && v.check == check && v.cost == q.cost );
+    cache.insert( key, { 1, 1, 1, check } );
+    CHECK( service.submit( r ).get().cost == 1 );
+    SharedCache::Remove( name );
+  }
+
+  ///7. Both digests are canonical: alike for the same part in any order and
+  ///   direction, and apart for parts that differ
+  {
+    std::vector<Vec2> p = { { 0, 0 }, { 3, 0 }, { 3, 1 }, { 1, 2 }, { 0, 1 } }, q = p;
+    std::reverse( q.begin(), q.end() );
+    std::rotate( q.begin(), q.begin() + 2, q.end() );
+    Data a = test::Read( test::Part().polygon( p ) ), b = test::Read( test::Part().polygon( q ) );
+    CHECK( a.hash() == b.hash() && a.check() == b.check() );
+    p[3].x += 1e-9;
+    Data c = test::Read( test::Part().polygon( p ) );
+    CHECK( a.hash() != c.hash() && a.check() != c.check() );
+  }
+
+  ///8. A failing snapshot write is reported to the caller, and cleared once one succeeds
+  {
+    std::string name = "/ccservice" + std::to_string( getpid() );
+    SharedCache::Remove( name );
+    SharedCache cache( name, 64 );
+    std::string path = "/tmp/ccservice" + std::to_string( getpid() ) + ".snap";
+    {
+      QuoteService service;
+      service.cache( &cache );
+      service.snapshot( "/nonexistent/cc.snap", std::chrono::seconds(3600) );
+      CHECK( service.snapshotError().empty() );
+      service.snapshotNow();
+      CHECK( service.snapshotError() == "Error: Cannot Write Snapshot." );
+    }
+    {
+      QuoteService service;
+      service.cache( &cache );
+      service.snapshot( path, std::chrono::seconds(3600) );
+      service.snapshotNow();
+      CHECK( service.snapshotError().empty() );
+      CHECK( std::ifstream( path.c_str() ).good() );
+    }
+    ///   and the last is written on shutdown, however long the interval
+    remove( path.c_str() );
+    {
+      QuoteService service;
+      service.cache( &cache );
+      service.snapshot( path, std::chrono::seconds(3600) );
+    }
+    CHECK( std::ifstream( path.c_str() ).good() );
+    remove( path.c_str() );
+    SharedCache::Remove( name );
+  }
+
+  return test::Report();
+}
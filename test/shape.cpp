@@ -0,0 +1,117 @@
+/// Checks the closed forms of Shape against the general path: boxes of
+/// rectangles and convex polygons against the minimum box of the hull of
+/// discretize(), and circles against discretizations approaching 2r; and
+/// that tiers bound the box area() prices, from closed forms or simplified
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Circle of radius r about c as k counterclockwise arcs, starting at angle t
+test::Part Circle( Vec2 c, double r, int k, double t ){
+  test::Part part;
+  for (int i=0;i<k;++i) part.vertex( Vec2::Construct( c, t + 2*PI*i/k, r ) );
+  for (int i=0;i<k;++i) part.arc( i+1, i+1 < k ? i+2 : 1, c );
+  return part;
+}
+
+/// Minimum box of the hull of the discretized part, as the general path finds it
+Hull::Box General( Data& data ){
+  auto points = data.discretize();
+  auto hull = Hull::Convex( points );
+  return Hull::MinimumBox( hull );
+}
+
+int main(){
+
+  std::mt19937 rng( 49 );
+  std::uniform_real_distribution<double> u( -1, 1 ), side( .1, 20 ), turn( 0, 2*PI );
+
+  ///1. Rectangles at any turn, either way round: the box of their sides
+  for (int k=0;k<20;++k){
+    double w = side(rng), h = side(rng), t = turn(rng);
+    Vec2 o = { 10 * u(rng), 10 * u(rng) }, a = { cos(t), sin(t) }, b = { -sin(t), cos(t) };
+    std::vector<Vec2> p = { o, o + Vec2{ a.x * w, a.y * w }, o + Vec2{ a.x * w + b.x * h, a.y * w + b.y * h }, o + Vec2{ b.x * h, b.y * h } };
+    if (k % 2) std::reverse( p.begin(), p.end() );
+    Data data = test::Read( test::Part().polygon( p ), 100 );
+    CHECK( data.shape().kind == Shape::Rectangle );
+    Hull::Box box = data.box(), general = General( data );
+    CHECK_NEAR( box.width * box.height, w * h, 1e-9 );
+    CHECK_NEAR( box.width * box.height, general.width * general.height, 1e-9 );
+    CHECK_NEAR( std::max( box.width, box.height ), std::max( general.width, general.height ), 1e-9 );
+  }
+
+  ///2. Convex polygons: calipers on their vertices find the general path's box
+  for (int k=0;k<50;++k){
+    std::vector<Vec2> cloud;
+    int n = 5 + rng() % 40;
+    for (int i=0;i<n;++i) cloud.push_back( { u(rng) * (1 + k%5), u(rng) } );
+    auto p = Hull::Convex( cloud );
+    if (p.size() < 3) continue;
+    if (p.size() == 4) continue;   // might be a rectangle
+    if (k % 2) std::reverse( p.begin(), p.end() );
+    Data data = test::Read( test::Part().polygon( p ), 100 );
+    CHECK( data.shape().kind == Shape::Convex );
+    Hull::Box box = data.box(), general = General( data );
+    CHECK_NEAR( box.width * box.height, general.width * general.height, 1e-9 );
+  }
+
+  ///3. Circles of one to four arcs: 2r, which discretizations approach from below
+  for (int k=1;k<=4;++k){
+    double r = side(rng) / 4, t = turn(rng);
+    Vec2 c = { 10 * u(rng), 10 * u(rng) };
+    for (int res : { 8, 64, 1024 }){
+      Data data = test::Read( Circle( c, r, k, t ), res );
+      CHECK( data.shape().kind == Shape::Circle );
+      CHECK_NEAR( data.shape().radius, r, 1e-9 );
+      Hull::Box box = data.box(), general = General( data );
+      CHECK_NEAR( box.width, 2*r, 1e-12 );
+      CHECK_NEAR( box.height, 2*r, 1e-12 );
+      // the discretized circle has k * res steps, so spans at least 2r cos( pi / (k res) )
+      double least = 2*r * cos( PI / (k * res) );
+      CHECK( general.width <= 2*r * (1 + 1e-12) && general.width >= least * (1 - 1e-12) );
+      CHECK( general.height <= 2*r * (1 + 1e-12) && general.height >= least * (1 - 1e-12) );
+    }
+  }
+
+  ///4. A circle's tier is priced from its closed form box, not from bounds on its steps
+  {
+    Data data = test::Read( Circle( { 0, 0 }, 3, 4, .3 ), 8 );
+    Profile f;
+    Tiers tiers;
+    tiers.bounds = { 1, 10, 100 };
+    Tiered t = data.tier( f, tiers );
+    double exact = data.seconds(f) * f.perSecond + data.area(f) * f.perUnitArea;
+    CHECK( t.bExact );
+    CHECK_NEAR( t.cost, exact, 1e-12 );
+    CHECK( t.tier == tiers( exact ) );
+  }
+
+  ///5. Thin, ragged strips simplified thinner, or down to their spine (too
+  ///   few points to bound, so priced exactly): the cheap bounds are of the
+  ///   simplified points, so they hold the box priced
+  for (int k=0;k<20;++k){
+    double w = side(rng), h = .01 + .05 * (u(rng) + 1), t = turn(rng);
+    int n = 50 + rng() % 200;
+    std::vector<Vec2> p;
+    for (int i=0;i<2*n;++i){
+      double x = i < n ? w * i / n : w * (2*n - i) / n, y = (i < n ? 0 : h) + h / 4 * u(rng);
+      p.push_back( { x * cos(t) - y * sin(t), x * sin(t) + y * cos(t) } );
+    }
+    Data data = test::Read( test::Part().polygon( p ), 20, 0 );
+    CHECK( !data.shape().closed() );
+    data.simplify( k % 2 ? 2 * h : h / 2 );
+    Profile f;
+    f.kerf = f.padding = 0;
+    Tiers tiers;
+    tiers.bounds = { 1e9 };
+    Tiered c = data.tier( f, tiers ), e = data.tier( f, tiers, true );
+    CHECK( e.bExact && c.bExact == (k % 2 == 1) );
+    CHECK( c.low <= e.cost * (1 + 1e-9) && e.cost <= c.high * (1 + 1e-9) );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,107 @@
+/// Checks that Simplify::Polyline keeps every dropped point within tolerance
+/// of the reduced chain, that the hull of what it keeps is short of the
+/// original hull's area by no more than Simplify::Bound, and its minimum box
+/// short of the original's by no more than the Bound of the reduced box, as
+/// Data::loss reports for simplified parts
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+/// Area of a convex polygon
+double Area( const std::vector<Vec2>& hull ){
+  double a = 0;
+  for (size_t i=0;i<hull.size();++i) a += Vec2::Cross( hull[i], hull[(i+1)%hull.size()] ) / 2;
+  return fabs( a );
+}
+
+/// Perimeter of a convex polygon
+double Perimeter( const std::vector<Vec2>& hull ){
+  double p = 0;
+  for (size_t i=0;i<hull.size();++i) p += (hull[(i+1)%hull.size()] - hull[i]).norm();
+  return p;
+}
+
+/// Distance of p from the closed chain through points
+double Distance( const Vec2& p, const std::vector<Vec2>& points ){
+  double best = 1e300;
+  for (size_t i=0;i<points.size();++i){
+    Vec2 a = points[i], d = points[(i+1)%points.size()] - a;
+    double l2 = Vec2::Dot( d, d ), t = l2 > 0 ? std::max( 0.0, std::min( 1.0, Vec2::Dot( p - a, d ) / l2 ) ) : 0;
+    best = std::min( best, (p - (a + Vec2{ d.x * t, d.y * t })).norm() );
+  }
+  return best;
+}
+
+/// Wavy, noisy loop of n points, x scaled by sx and turned by t
+std::vector<Vec2> Wavy( int n, double sx, double t, double noise, std::mt19937& rng ){
+  std::uniform_real_distribution<double> u( -1, 1 );
+  std::vector<Vec2> p;
+  for (int i=0;i<n;++i){
+    double a = 2*PI * i / n, r = 1 + .1 * sin( 5 * a ) + noise * u(rng);
+    Vec2 q = { sx * r * cos(a), r * sin(a) };
+    p.push_back( { q.x * cos(t) - q.y * sin(t), q.x * sin(t) + q.y * cos(t) } );
+  }
+  return p;
+}
+
+int main(){
+
+  std::mt19937 rng( 44 );
+  std::uniform_real_distribution<double> u( 0, 1 );
+
+  ///1. Noisy loops reduced at several tolerances: every point near the
+  ///   reduced chain, hull and box areas short by no more than their bounds
+  for (int k=0;k<20;++k){
+    auto points = Wavy( 200 + 100 * (k % 5), 1 + 3 * u(rng), 2*PI * u(rng), .05 * u(rng), rng );
+    std::vector<Vec2> scratch = points;
+    auto hull = Hull::Convex( scratch );
+    Hull::Box box = Hull::MinimumBox( hull );
+    for (double tolerance : { .001, .01, .05, .2 }){
+      auto reduced = Simplify::Polyline( points, tolerance, true );
+      CHECK( reduced.size() <= points.size() );
+      double far = 0;
+      for (auto& p : points) far = std::max( far, Distance( p, reduced ) );
+      CHECK( far <= tolerance * (1 + 1e-9) );
+      scratch = reduced;
+      auto less = Hull::Convex( scratch );
+      double lost = Area( hull ) - Area( less );
+      CHECK( lost >= -1e-12 && lost <= Simplify::Bound( Perimeter( hull ), tolerance ) );
+      Hull::Box b = Hull::MinimumBox( less );
+      double shrunk = box.width * box.height - b.width * b.height;
+      CHECK( shrunk >= -1e-12 && shrunk <= Simplify::Bound( b, tolerance ) );
+    }
+  }
+
+  ///2. Parts of thousands of vertices: the box of the simplified hull falls
+  ///   short of that of every vertex by no more than loss(), which is 0
+  ///   without simplifying
+  for (int k=0;k<6;++k){
+    test::Part part;
+    part.polygon( Wavy( 2000 + 1000 * k, 1 + u(rng), 2*PI * u(rng), .01, rng ) );
+    Data data = test::Read( part );
+    CHECK( data.loss() == 0 );
+    auto all = data.discretize();
+    Hull::Box exact = Hull::MinimumBox( Hull::Convex( all ) );
+    for (double tolerance : { .002, .02 }){
+      data.simplify( tolerance );
+      Hull::Box b = Hull::MinimumBox( data.hull() );
+      double shrunk = exact.width * exact.height - b.width * b.height;
+      CHECK_NEAR( data.loss(), Simplify::Bound( b, tolerance ), 1e-12 );
+      CHECK( shrunk >= -1e-12 && shrunk <= data.loss() );
+    }
+  }
+
+  ///3. Closed forms are never simplified
+  {
+    Data data = test::Read( test::Part().polygon( { { 0, 0 }, { 2, 0 }, { 2, 1 }, { 0, 1 } } ) );
+    double area = data.area();
+    data.simplify( .1 );
+    CHECK( data.loss() == 0 && data.area() == area );
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,90 @@
+/// Checks that Small::Convex returns the loop Hull::Convex does and that
+/// Small::MinimumBox finds a box of the area Hull::MinimumBox does, flush
+/// with an edge, on clouds either side of each capacity (with repeated and
+/// collinear points), and prints the time each takes
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <random>
+
+using namespace cc;
+
+typedef std::chrono::steady_clock Clock;
+
+/// Microseconds per call of f, best of five runs of reps calls
+template< class F >
+double Time( int reps, F f ){
+  double best = 1e300;
+  for (int r=0;r<5;++r){
+    auto t0 = Clock::now();
+    for (int i=0;i<reps;++i) f();
+    best = std::min( best, std::chrono::duration<double,std::micro>( Clock::now() - t0 ).count() / reps );
+  }
+  return best;
+}
+
+/// Is w x h the box of the hull along one of its edges, of the least area of those?
+bool Flush( const std::vector<Vec2>& hull, double w, double h ){
+  int n = hull.size();
+  double least = 1e300;
+  bool found = false;
+  for (int i=0;i<n;++i){
+    Vec2 e = ( hull[(i+1)%n] - hull[i] ).unit(), f = { -e.y, e.x };
+    double a0 = 1e300, a1 = -1e300, b0 = 1e300, b1 = -1e300;
+    for (auto& v : hull){
+      a0 = std::min( a0, Vec2::Dot( e, v ) ); a1 = std::max( a1, Vec2::Dot( e, v ) );
+      b0 = std::min( b0, Vec2::Dot( f, v ) ); b1 = std::max( b1, Vec2::Dot( f, v ) );
+    }
+    double x = a1 - a0, y = b1 - b0;
+    least = std::min( least, x * y );
+    if ((test::Near( w, x, 1e-9 ) && test::Near( h, y, 1e-9 )) || (test::Near( w, y, 1e-9 ) && test::Near( h, x, 1e-9 ))) found = true;
+  }
+  return found && test::Near( w * h, least, 1e-9 );
+}
+
+int main(){
+
+  std::mt19937 rng( 50 );
+  std::uniform_real_distribution<double> u( -1, 1 );
+  std::uniform_int_distribution<int> grid( -3, 3 );
+
+  ///1. Random and grid clouds of every size up to past Max: the same hull and box
+  for (int n=1;n<=Small::Max+16;++n){
+    for (int k=0;k<20;++k){
+      std::vector<Vec2> cloud;
+      for (int i=0;i<n;++i){
+        // grids repeat points and line them up
+        if (k % 2) cloud.push_back( { (double)grid(rng), (double)grid(rng) } );
+        else cloud.push_back( { u(rng) * (1 + k%4), u(rng) } );
+      }
+      std::vector<Vec2> a = cloud, b = cloud;
+      auto small = Small::Convex( a );
+      auto hull = Hull::Convex( b );
+      CHECK( small == hull );
+      if (hull.size() < 3) continue;
+      Hull::Box s = Small::MinimumBox( hull ), h = Hull::MinimumBox( hull );
+      CHECK_NEAR( s.width * s.height, h.width * h.height, 1e-9 );
+      // boxes of equal area (every edge of a triangle has one) may differ in sides
+      CHECK( Flush( hull, s.width, s.height ) );
+    }
+  }
+
+  ///2. Time both on clouds at each capacity
+  for (int n : { 8, 16, 32, 64 }){
+    std::vector<Vec2> cloud;
+    for (int i=0;i<n;++i) cloud.push_back( { u(rng), u(rng) } );
+    std::vector<Vec2> scratch;
+    auto hull = Hull::Convex( scratch = cloud );
+    volatile double sink = 0;   // keeps the calls from being optimized away
+    double smallHull = Time( 2000, [&]{ scratch = cloud; sink = sink + Small::Convex( scratch ).size(); } );
+    double hullHull = Time( 2000, [&]{ scratch = cloud; sink = sink + Hull::Convex( scratch ).size(); } );
+    double smallBox = Time( 2000, [&]{ sink = sink + Small::MinimumBox( hull ).width; } );
+    double hullBox = Time( 2000, [&]{ sink = sink + Hull::MinimumBox( hull ).width; } );
+    printf( "%2d points (%2d on the hull): Convex %.3fus (Hull %.3fus), MinimumBox %.3fus (Hull %.3fus)\n",
+            n, (int)hull.size(), smallHull, hullHull, smallBox, hullBox );
+  }
+
+  return test::Report();
+}
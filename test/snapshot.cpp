@@ -0,0 +1,86 @@
+/// Checks that snapshots written to one path by several processes at once
+/// are each read back whole, and that no temporary file is left behind
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <dirent.h>
+#include <sys/wait.h>
+
+using namespace cc;
+
+/// Number of quotes writer i puts in its snapshots
+int Size( int i ){ return 40 + 25 * i; }
+
+/// Is every quote of the writer whose snapshot this is found, and no other?
+bool Whole( const Snapshot& s ){
+  for (int i=0;i<4;++i){
+    if ((int)s.quotes() != Size(i)) continue;
+    SharedCache::Value v;
+    for (int k=0;k<Size(i);++k){
+      if (!s.find( 1000 * i + k + 1, v ) || v.cost != 1000 * i + k + 1) return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+int main(){
+
+  char dir[] = "/tmp/ccsnapshotXXXXXX";
+  if (!mkdtemp( dir )) return 1;
+  std::string path = std::string( dir ) + "/quotes.snap";
+
+  ///1. Four writers replace one snapshot while it is read: every read is one writer's whole snapshot
+  std::vector<pid_t> writers;
+  for (int i=0;i<4;++i){
+    pid_t child = fork();
+    if (child == 0){
+      std::string name = "/ccsnapshot" + std::to_string( getpid() );
+      SharedCache::Remove( name );
+      int failed = 0;
+      {
+        SharedCache cache( name, 1024 );
+        for (int k=0;k<Size(i);++k) cache.insert( 1000 * i + k + 1, { 0, 0, (double)(1000 * i + k + 1) } );
+        for (int n=0;n<40;++n){
+          try { Snapshot::Write( path, cache ); }
+          catch (std::invalid_argument&) { failed++; }
+        }
+      }
+      SharedCache::Remove( name );
+      _exit( failed );
+    }
+    writers.push_back( child );
+  }
+  int reads = 0;
+  for (int n=0;n<2000;++n){
+    Snapshot s;
+    if (!s.open( path )) continue;
+    reads++;
+    CHECK( Whole( s ) );
+  }
+  for (pid_t w : writers){
+    int status = -1;
+    waitpid( w, &status, 0 );
+    CHECK( WIFEXITED(status) && WEXITSTATUS(status) == 0 );
+  }
+  Snapshot last( path );
+  CHECK( Whole( last ) );
+  printf( "%d snapshots read while written\n", reads );
+
+  ///2. Only the snapshot itself is left in its directory
+  int files = 0;
+  DIR * d = opendir( dir );
+  while (dirent * e = readdir( d )){
+    std::string file = e->d_name;
+    if (file == "." || file == "..") continue;
+    files++;
+    CHECK( file == "quotes.snap" );
+    unlink( ( std::string( dir ) + "/" + file ).c_str() );
+  }
+  closedir( d );
+  rmdir( dir );
+  CHECK( files == 1 );
+
+  return test::Report();
+}
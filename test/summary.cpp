@@ -0,0 +1,92 @@
+/// Checks that a Summary prices parts as Data::cost does, within the stated
+/// bound of Summary::seconds, for arcs far apart in radius, for random
+/// rounded rectangles under several falloffs, and for arcs of more radii
+/// than a Summary has runs
+
+#include "cc.hpp"
+#include "check.hpp"
+
+#include <random>
+
+using namespace cc;
+
+int main(){
+
+  const double slack = 1e-5;   // float accumulation of the runs
+
+  ///1. Arcs of radii .0885 and .124: mean curvature prices them at a third of their time
+  {
+    Profile f;
+    Summary s;
+    s.add( 1, .0885 );
+    s.add( 1, .124 );
+    double t = ( exp( f.falloff / .0885 ) + exp( f.falloff / .124 ) ) / f.velocity;
+    CHECK( s.seconds(f) >= t * (1 - slack) );
+    CHECK( s.seconds(f) <= t * exp( fabs(f.falloff) * Summary::Step ) * (1 + slack) );
+  }
+
+  ///2. Arcs in one run are priced within the bound either way round
+  {
+    Summary s;
+    s.add( 2, 1.0 / 4.01 );
+    s.add( 3, 1.0 / 4.24 );
+    for (double falloff : { -2.0, -1.0, .5, 1.0, 2.0 }){
+      Profile f;
+      f.falloff = falloff;
+      double t = ( 2 * exp( falloff * 4.01 ) + 3 * exp( falloff * 4.24 ) ) / f.velocity;
+      CHECK( s.seconds(f) >= t * (1 - slack) );
+      CHECK( s.seconds(f) <= t * exp( fabs(falloff) * Summary::Step ) * (1 + slack) );
+    }
+  }
+
+  ///3. Random rounded rectangles: summary().cost(f) against Data::cost(f)
+  std::mt19937 rng( 27 );
+  std::uniform_real_distribution<double> side( 1, 10 ), radius( .02, .5 );
+  std::vector<Profile> profiles;
+  for (double falloff : { .25, .5, 1.0, 2.0 }){
+    Profile f;
+    f.falloff = falloff;
+    profiles.push_back( f );
+  }
+  for (int k=0;k<50;++k){
+    double r[4] = { radius(rng), radius(rng), radius(rng), radius(rng) };
+    Data data = test::Read( test::Part().rounded( side(rng), side(rng), r ) );
+    Summary s = data.summary();
+    std::vector<double> costs = data.cost( profiles );
+    for (size_t p=0;p<profiles.size();++p){
+      const Profile& f = profiles[p];
+      double bound = exp( fabs(f.falloff) * Summary::Step );
+      CHECK( s.cost(f) >= costs[p] * (1 - slack) );
+      CHECK( s.cost(f) <= costs[p] * bound * (1 + slack) );
+    }
+  }
+
+  ///4. Arcs of up to Runs radii far apart keep a run each, within Step; of
+  ///   more, merged runs widen, and the bound widens with them
+  std::uniform_real_distribution<double> length( .01, 2 );
+  CHECK( sizeof(Summary) <= 512 );
+  for (int n : { 4, Summary::Runs, 3 * Summary::Runs, 200 }){
+    for (int k=0;k<5;++k){
+      std::vector<double> radii;
+      for (int i=0;i<n;++i) radii.push_back( n > Summary::Runs ? radius(rng) : 1 / (.1 + i + .2 * radius(rng)) );
+      Summary s;
+      std::vector< std::pair<double,double> > arcs;
+      for (int i=0;i<4*n;++i){
+        double r = radii[ rng() % n ], l = length(rng);
+        s.add( l, r );
+        arcs.push_back( { l, r } );
+      }
+      CHECK( n > Summary::Runs || s.spread() <= Summary::Step );
+      for (double falloff : { -1.0, .1, .5 }){
+        Profile f;
+        f.falloff = falloff;
+        double t = 0;
+        for (auto& a : arcs) t += a.first * exp( falloff / a.second ) / f.velocity;
+        CHECK( s.seconds(f) >= t * (1 - slack) );
+        CHECK( s.seconds(f) <= t * exp( fabs(falloff) * s.spread() ) * (1 + slack) );
+      }
+    }
+  }
+
+  return test::Report();
+}
@@ -0,0 +1,58 @@
+/// Checks that Topology::Check takes an arc with both ends on one vertex for
+/// a full circle, and that a part made of one reads, times and classifies as
+/// the same circle made of four quarter arcs
+
+#include "cc.hpp"
+#include "check.hpp"
+
+using namespace cc;
+
+/// Unit circle about the origin as one arc from and to vertex 1
+test::Part Whole( bool clockwise ){
+  test::Part part;
+  int v = part.vertex( { 1, 0 } );
+  part.arc( v, v, { 0, 0 }, clockwise );
+  return part;
+}
+
+/// Unit circle about the origin as four counterclockwise quarter arcs
+test::Part Quarters(){
+  test::Part part;
+  for (Vec2 v : { Vec2{ 1, 0 }, Vec2{ 0, 1 }, Vec2{ -1, 0 }, Vec2{ 0, -1 } }) part.vertex( v );
+  for (int i=0;i<4;++i) part.arc( i+1, (i+1)%4+1, { 0, 0 } );
+  return part;
+}
+
+int main(){
+
+  ///1. One vertex: malformed for a line, a closed loop for an arc
+  {
+    std::vector<int> ids = { 7 };
+    std::vector< std::vector<int> > edges = { { 7, 7 } };
+    CHECK( Topology::Check( ids, edges ).malformed == 1 );
+    CHECK( Topology::Check( ids, edges, { 0 } ).malformed == 1 );
+    Topology t = Topology::Check( ids, edges, { 1 } );
+    CHECK( t.valid() && t.closed() );
+    CHECK( t.components == 1 && t.open == 0 && t.dangling == 0 && t.branching == 0 );
+  }
+
+  ///2. Two arcs and a line: only the line on one vertex is malformed
+  {
+    std::vector<int> ids = { 1, 2 };
+    std::vector< std::vector<int> > edges = { { 1, 1 }, { 2, 2 }, { 1, 2 } };
+    Topology t = Topology::Check( ids, edges, { 1, 0, 0 } );
+    CHECK( t.malformed == 1 && !t.valid() );
+  }
+
+  ///3. A circle of one arc reads as the circle of four, either way round
+  Data four = test::Read( Quarters() );
+  for (bool clockwise : { false, true }){
+    Data one = test::Read( Whole( clockwise ) );
+    CHECK( one.topology().valid() && one.topology().closed() );
+    CHECK( one.shape().kind == Shape::Circle );
+    CHECK_NEAR( one.shape().radius, 1, 1e-12 );
+    CHECK_NEAR( one.seconds(), four.seconds(), 1e-9 );
+  }
+
+  return test::Report();
+}
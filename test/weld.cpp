@@ -0,0 +1,55 @@
+/// Checks that welding keeps an arc whose ends it merges as a full circle
+/// when the arc swept more than a half turn, and collapses it otherwise,
+/// as it does straight edges
+
+#include "cc.hpp"
+#include "check.hpp"
+
+using namespace cc;
+
+/// 10 x 10 square with a clockwise hole of radius 1 about (5,5), drawn from
+/// (6,5) round to (6,5+gap) as vertices 5 and 6 (or on vertex 5 alone if gap < 0)
+test::Part Holed( double gap ){
+  test::Part part;
+  part.polygon( { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 } } );
+  int a = part.vertex( { 6, 5 } ), b = gap >= 0 ? part.vertex( { 6, 5 + gap } ) : a;
+  part.arc( a, b, { 5, 5 }, true );
+  return part;
+}
+
+/// Triangle whose corner at (10,0) is cut by a counterclockwise arc about
+/// the origin, of length gap, to (10,gap)
+test::Part Chipped( double gap ){
+  test::Part part;
+  int a = part.vertex( { 0, 0 } ), b = part.vertex( { 10, 0 } ), c = part.vertex( { 10, gap } ), d = part.vertex( { 0, 10 } );
+  part.line( a, b ).arc( b, c, { 0, 0 } ).line( c, d ).line( d, a );
+  return part;
+}
+
+int main(){
+
+  ///1. A hole between coincident vertices is the hole drawn on one vertex
+  Data whole = test::Read( Holed( -1 ) );
+  CHECK( whole.topology().closed() && whole.topology().components == 2 );
+  for (double gap : { 0.0, 1e-7 }){
+    Data holed = test::Read( Holed( gap ) );
+    CHECK( holed.topology().closed() && holed.topology().components == 2 );
+    CHECK( holed.topology().welded == 1 && holed.topology().collapsed == 0 );
+    CHECK_NEAR( holed.seconds(), whole.seconds(), 1e-6 );
+    CHECK_NEAR( holed.area(), whole.area(), 1e-6 );
+  }
+
+  ///2. With no welding the hole stays open, and is still cut as a full circle
+  Data open = test::Read( Holed( 1e-7 ), 20, 0 );
+  CHECK( open.topology().valid() && !open.topology().closed() );
+  CHECK( open.topology().welded == 0 );
+  CHECK_NEAR( open.seconds(), whole.seconds(), 1e-6 );
+
+  ///3. An arc shorter than the tolerance collapses, leaving the triangle
+  Data chipped = test::Read( Chipped( 1e-7 ) );
+  CHECK( chipped.topology().closed() && chipped.topology().components == 1 );
+  CHECK( chipped.topology().welded == 1 && chipped.topology().collapsed == 1 );
+  CHECK( chipped.topology().edges == 3 );
+
+  return test::Report();
+}